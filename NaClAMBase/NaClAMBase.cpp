@@ -15,10 +15,26 @@
 #include "json/json.h"
 #include "NaClAMBase.h"
 #include "NaClAMMessageCollector.h"
+#include "NaClAMJsonWriter.h"
 
 ModuleInterfaces moduleInterfaces;
 PP_Instance moduleInstance = 0;
 NaClAMMessageCollector messageCollector;
+/* Outgoing header text, reused so replies do not allocate once warm. */
+static std::string headerText;
+
+#define LOG_BUFFER_SIZE (32 * 1024)
+#define LOG_MAX_LINES 256
+#define LOG_LINE_SIZE 1024
+/* Log lines waiting for the next heartbeat, each stored as a level byte
+ * followed by the NUL terminated text. Full buffers drop and count. The
+ * last quarter is kept for warnings and errors so a flood of chatter
+ * cannot hide them. */
+static char logBuffer[LOG_BUFFER_SIZE];
+static uint32_t logBufferUsed = 0;
+static uint32_t logLines = 0;
+static uint32_t logDropped[NACLAM_LOG_LEVELS];
+static pthread_mutex_t logMutex = PTHREAD_MUTEX_INITIALIZER;
 
 static uint64_t microseconds() {
   struct timeval tv;
@@ -43,46 +59,132 @@ void NaClAMSendMessage(const PP_Var& header, const PP_Var* frames, uint32_t numF
   }
 }
 
-void NaClAMSendMessage(const Json::Value& header, const PP_Var* frames, uint32_t numFrames) {
-  Json::StyledWriter writer;
-  Json::Value root = header;
-  root["frames"] = Json::Value(numFrames);
-  std::string jsonMessage = writer.write(root);
-  PP_Var msgVar = moduleInterfaces.var->VarFromUtf8(jsonMessage.c_str(), 
-    jsonMessage.length());
+static void sendHeaderText(const PP_Var* frames, uint32_t numFrames) {
+  PP_Var msgVar = moduleInterfaces.var->VarFromUtf8(headerText.data(),
+                                                    headerText.length());
   NaClAMSendMessage(msgVar, frames, numFrames);
   moduleInterfaces.var->Release(msgVar);
 }
 
-static void messagePrint(const char* str) {
-  Json::StyledWriter writer;
-  Json::Value root;
-  root["frames"] = Json::Value(0);
-  root["request"] = Json::Value(-1);
-  root["cmd"] = Json::Value("NaClAMPrint");
-  root["print"] = Json::Value(str);
-  std::string jsonMessage = writer.write(root);
-  PP_Var msgVar = moduleInterfaces.var->VarFromUtf8(jsonMessage.c_str(),
-                                                    jsonMessage.length());
-  NaClAMSendMessage(msgVar, NULL, 0);
-  moduleInterfaces.var->Release(msgVar);
+void NaClAMSendMessage(const Json::Value& header, const PP_Var* frames, uint32_t numFrames) {
+  /* Written compactly straight from header; "frames" goes first instead of
+   * copying header just to add it. */
+  headerText.clear();
+  headerText += "{\"frames\":";
+  NaClAMWriteJsonInt(headerText, numFrames);
+  if (header.isObject()) {
+    for (Json::Value::const_iterator it = header.begin(); it != header.end(); ++it) {
+      if (strcmp(it.memberName(), "frames") == 0) {
+        continue;
+      }
+      headerText += ',';
+      NaClAMWriteJsonString(headerText, it.memberName());
+      headerText += ':';
+      NaClAMWriteJson(headerText, *it);
+    }
+  }
+  headerText += '}';
+  sendHeaderText(frames, numFrames);
+}
+
+static void logv(int level, const char* str, va_list vl) {
+  char line[LOG_LINE_SIZE];
+  int length = vsnprintf(line, sizeof(line), str, vl);
+  if (length < 0) {
+    return;
+  }
+  if (length >= LOG_LINE_SIZE) {
+    length = LOG_LINE_SIZE - 1;
+  }
+  // The console adds its own line break.
+  if (length > 0 && line[length - 1] == '\n') {
+    line[--length] = '\0';
+  }
+  if (level < NACLAM_LOG_DEBUG) {
+    level = NACLAM_LOG_DEBUG;
+  } else if (level > NACLAM_LOG_ERROR) {
+    level = NACLAM_LOG_ERROR;
+  }
+  uint32_t maxLines = LOG_MAX_LINES;
+  uint32_t maxBytes = LOG_BUFFER_SIZE;
+  if (level < NACLAM_LOG_WARNING) {
+    maxLines -= LOG_MAX_LINES / 4;
+    maxBytes -= LOG_BUFFER_SIZE / 4;
+  }
+  pthread_mutex_lock(&logMutex);
+  if (logLines < maxLines && logBufferUsed + length + 2 <= maxBytes) {
+    logBuffer[logBufferUsed] = char(level);
+    memcpy(&logBuffer[logBufferUsed + 1], line, length + 1);
+    logBufferUsed += length + 2;
+    logLines++;
+  } else {
+    logDropped[level]++;
+  }
+  pthread_mutex_unlock(&logMutex);
+}
+
+void NaClAMLogf(int level, const char* str, ...) {
+  va_list vl;
+  va_start(vl, str);
+  logv(level, str, vl);
+  va_end(vl);
 }
 
 void NaClAMPrintf(const char* str, ...) {
-  const int bufferSize = 1024;
-  char buff[bufferSize];
-  buff[0] = '\0';
   va_list vl;
   va_start(vl, str);
-  vsnprintf(&buff[0], bufferSize, str, vl);
+  logv(NACLAM_LOG_INFO, str, vl);
   va_end(vl);
-  messagePrint(buff);
+}
+
+/* Sends everything logged since the last heartbeat as one message. */
+static void flushLog() {
+  pthread_mutex_lock(&logMutex);
+  bool dropped = false;
+  for (int i = 0; i < NACLAM_LOG_LEVELS; i++) {
+    dropped |= logDropped[i] != 0;
+  }
+  if (logLines == 0 && !dropped) {
+    pthread_mutex_unlock(&logMutex);
+    return;
+  }
+  headerText.clear();
+  headerText += "{\"cmd\":\"NaClAMLog\",\"dropped\":[";
+  for (int i = 0; i < NACLAM_LOG_LEVELS; i++) {
+    if (i > 0) {
+      headerText += ',';
+    }
+    NaClAMWriteJsonInt(headerText, logDropped[i]);
+    logDropped[i] = 0;
+  }
+  headerText += "],\"frames\":0,\"levels\":[";
+  for (uint32_t offset = 0; offset < logBufferUsed;
+       offset += strlen(&logBuffer[offset + 1]) + 2) {
+    if (offset > 0) {
+      headerText += ',';
+    }
+    NaClAMWriteJsonInt(headerText, logBuffer[offset]);
+  }
+  headerText += "],\"lines\":[";
+  for (uint32_t offset = 0; offset < logBufferUsed;
+       offset += strlen(&logBuffer[offset + 1]) + 2) {
+    if (offset > 0) {
+      headerText += ',';
+    }
+    NaClAMWriteJsonString(headerText, &logBuffer[offset + 1]);
+  }
+  headerText += "],\"request\":-1}";
+  logBufferUsed = 0;
+  logLines = 0;
+  pthread_mutex_unlock(&logMutex);
+  sendHeaderText(NULL, 0);
 }
 
 
 
 static void heartBeat(void* userdata, int32_t result) {
   NaClAMModuleHeartBeat(microseconds());
+  flushLog();
   PP_CompletionCallback ccb;
   ccb.func = heartBeat;
   ccb.user_data = NULL;
@@ -139,7 +241,7 @@ static void HandleMessage(PP_Instance, struct PP_Var message) {
   messageCollector.Collect(message);
   if (messageCollector.IsMessageReady()) {
     //NaClAMPrintf("Message Ready.");
-    NaClAMMessage amMessage = messageCollector.GrabMessage();
+    const NaClAMMessage& amMessage = messageCollector.GrabMessage();
     NaClAMModuleHandleMessage(amMessage);
     messageCollector.ClearMessage();
   }
@@ -36,9 +36,56 @@ struct ModuleInterfaces {
 extern ModuleInterfaces moduleInterfaces;
 extern PP_Instance moduleInstance;
 
+/**
+ * Log severities, lowest first.
+ */
+#define NACLAM_LOG_DEBUG 0
+#define NACLAM_LOG_INFO 1
+#define NACLAM_LOG_WARNING 2
+#define NACLAM_LOG_ERROR 3
+#define NACLAM_LOG_LEVELS 4
+
+/**
+ * Log calls below this severity compile to nothing. Release builds (NDEBUG)
+ * strip debug logs unless the project defines its own level.
+ */
+#ifndef NACLAM_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define NACLAM_LOG_MIN_LEVEL NACLAM_LOG_INFO
+#else
+#define NACLAM_LOG_MIN_LEVEL NACLAM_LOG_DEBUG
+#endif
+#endif
+
+/**
+ * printf a log line at level. Lines are buffered and sent to JS once per
+ * heartbeat as a single NaClAMLog message. When more than a heartbeat's
+ * worth is logged the excess lines are dropped and counted instead.
+ * Safe to call from any thread.
+ * @param level One of the NACLAM_LOG_ severities.
+ */
+void NaClAMLogf(int level, const char*, ...);
+
+#if NACLAM_LOG_MIN_LEVEL <= NACLAM_LOG_DEBUG
+#define NaClAMLogDebug(...) NaClAMLogf(NACLAM_LOG_DEBUG, __VA_ARGS__)
+#else
+#define NaClAMLogDebug(...) ((void)0)
+#endif
+#if NACLAM_LOG_MIN_LEVEL <= NACLAM_LOG_INFO
+#define NaClAMLogInfo(...) NaClAMLogf(NACLAM_LOG_INFO, __VA_ARGS__)
+#else
+#define NaClAMLogInfo(...) ((void)0)
+#endif
+#if NACLAM_LOG_MIN_LEVEL <= NACLAM_LOG_WARNING
+#define NaClAMLogWarning(...) NaClAMLogf(NACLAM_LOG_WARNING, __VA_ARGS__)
+#else
+#define NaClAMLogWarning(...) ((void)0)
+#endif
+#define NaClAMLogError(...) NaClAMLogf(NACLAM_LOG_ERROR, __VA_ARGS__)
+
 /**
  *
- * printf a message which is sent to JS.
+ * printf a message which is sent to JS. Same as NaClAMLogInfo.
  */
 void NaClAMPrintf(const char*, ...);
 
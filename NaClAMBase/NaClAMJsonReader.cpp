@@ -0,0 +1,335 @@
+#include <stdlib.h>
+#include "NaClAMJsonReader.h"
+
+#define MAX_DEPTH 1000
+
+/**
+ * Recursive descent parser writing straight into the destination values.
+ * Unlike Json::Reader there is no token stack and no intermediate copies:
+ * containers are created in place and scalars are swapped into them.
+ */
+class NaClAMJsonParser {
+  char* _cur;
+  char* _end;
+  int _depth;
+
+  void SkipWhitespace() {
+    while (_cur < _end) {
+      char c = *_cur;
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        _cur++;
+      } else if (c == '/' && _cur + 1 < _end && _cur[1] == '/') {
+        while (_cur < _end && *_cur != '\n') {
+          _cur++;
+        }
+      } else if (c == '/' && _cur + 1 < _end && _cur[1] == '*') {
+        _cur += 2;
+        while (_cur + 1 < _end && !(_cur[0] == '*' && _cur[1] == '/')) {
+          _cur++;
+        }
+        _cur += 2;
+      } else {
+        break;
+      }
+    }
+  }
+
+  bool Match(const char* literal) {
+    const char* p = _cur;
+    while (*literal) {
+      if (p >= _end || *p != *literal) {
+        return false;
+      }
+      p++;
+      literal++;
+    }
+    _cur = (char*)p;
+    return true;
+  }
+
+  static int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  }
+
+  bool ParseHex4(unsigned int* codePoint) {
+    if (_end - _cur < 4) {
+      return false;
+    }
+    *codePoint = 0;
+    for (int i = 0; i < 4; i++) {
+      int digit = HexDigit(_cur[i]);
+      if (digit < 0) {
+        return false;
+      }
+      *codePoint = (*codePoint << 4) | digit;
+    }
+    _cur += 4;
+    return true;
+  }
+
+  static char* WriteUtf8(char* out, unsigned int cp) {
+    if (cp <= 0x7f) {
+      *out++ = (char)cp;
+    } else if (cp <= 0x7ff) {
+      *out++ = (char)(0xc0 | (cp >> 6));
+      *out++ = (char)(0x80 | (cp & 0x3f));
+    } else if (cp <= 0xffff) {
+      *out++ = (char)(0xe0 | (cp >> 12));
+      *out++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+      *out++ = (char)(0x80 | (cp & 0x3f));
+    } else {
+      *out++ = (char)(0xf0 | (cp >> 18));
+      *out++ = (char)(0x80 | ((cp >> 12) & 0x3f));
+      *out++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+      *out++ = (char)(0x80 | (cp & 0x3f));
+    }
+    return out;
+  }
+
+  /**
+   * Unescapes the string starting at the opening quote in place. The
+   * unescaped text is never longer than the escaped text so it always fits.
+   * @return The NUL terminated string or NULL on error.
+   */
+  char* ParseString() {
+    char* start = ++_cur;
+    char* out = _cur;
+    while (_cur < _end) {
+      char c = *_cur++;
+      if (c == '"') {
+        *out = '\0';
+        return start;
+      }
+      if (c != '\\') {
+        *out++ = c;
+        continue;
+      }
+      if (_cur >= _end) {
+        return NULL;
+      }
+      c = *_cur++;
+      switch (c) {
+        case '"': *out++ = '"'; break;
+        case '/': *out++ = '/'; break;
+        case '\\': *out++ = '\\'; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u': {
+          unsigned int cp;
+          if (!ParseHex4(&cp)) {
+            return NULL;
+          }
+          if (cp >= 0xd800 && cp <= 0xdbff) {
+            // Surrogate pair
+            unsigned int low;
+            if (!Match("\\u") || !ParseHex4(&low) || low < 0xdc00 || low > 0xdfff) {
+              return NULL;
+            }
+            cp = 0x10000 + ((cp & 0x3ff) << 10) + (low & 0x3ff);
+          }
+          out = WriteUtf8(out, cp);
+          break;
+        }
+        default:
+          return NULL;
+      }
+    }
+    return NULL;
+  }
+
+  /**
+   * Numbers without fraction or exponent become integers when they fit,
+   * like Json::Reader::decodeNumber.
+   */
+  bool ParseNumber(Json::Value& value) {
+    char* start = _cur;
+    bool isNegative = *_cur == '-';
+    if (isNegative) {
+      _cur++;
+    }
+    Json::Value::LargestUInt integer = 0;
+    bool overflow = false;
+    const Json::Value::LargestUInt maxIntegerValue =
+        isNegative ? Json::Value::LargestUInt(-Json::Value::minLargestInt)
+                   : Json::Value::maxLargestUInt;
+    char* digits = _cur;
+    while (_cur < _end && *_cur >= '0' && *_cur <= '9') {
+      unsigned int digit = *_cur - '0';
+      if (integer > (maxIntegerValue - digit) / 10) {
+        overflow = true;
+      }
+      integer = integer * 10 + digit;
+      _cur++;
+    }
+    if (_cur == digits) {
+      return false;
+    }
+    if (_cur < _end && (*_cur == '.' || *_cur == 'e' || *_cur == 'E')) {
+      overflow = true;
+    }
+    if (overflow) {
+      char* numberEnd;
+      double d = strtod(start, &numberEnd);
+      if (numberEnd == start || numberEnd > _end) {
+        return false;
+      }
+      _cur = numberEnd;
+      Json::Value number(d);
+      value.swap(number);
+    } else if (isNegative) {
+      Json::Value number(-Json::Value::LargestInt(integer));
+      value.swap(number);
+    } else if (integer <= Json::Value::LargestUInt(Json::Value::maxInt)) {
+      Json::Value::LargestInt smallInteger = integer;
+      Json::Value number(smallInteger);
+      value.swap(number);
+    } else {
+      Json::Value number(integer);
+      value.swap(number);
+    }
+    return true;
+  }
+
+  bool ParseObject(Json::Value& value) {
+    Json::Value object(Json::objectValue);
+    value.swap(object);
+    _cur++;
+    SkipWhitespace();
+    if (_cur < _end && *_cur == '}') {
+      _cur++;
+      return true;
+    }
+    while (_cur < _end) {
+      if (*_cur != '"') {
+        return false;
+      }
+      char* key = ParseString();
+      if (key == NULL) {
+        return false;
+      }
+      SkipWhitespace();
+      if (_cur >= _end || *_cur != ':') {
+        return false;
+      }
+      _cur++;
+      if (!ParseValue(value[Json::StaticString(key)])) {
+        return false;
+      }
+      SkipWhitespace();
+      if (_cur >= _end) {
+        return false;
+      }
+      if (*_cur == '}') {
+        _cur++;
+        return true;
+      }
+      if (*_cur != ',') {
+        return false;
+      }
+      _cur++;
+      SkipWhitespace();
+    }
+    return false;
+  }
+
+  bool ParseArray(Json::Value& value) {
+    Json::Value array(Json::arrayValue);
+    value.swap(array);
+    _cur++;
+    SkipWhitespace();
+    if (_cur < _end && *_cur == ']') {
+      _cur++;
+      return true;
+    }
+    Json::ArrayIndex index = 0;
+    while (_cur < _end) {
+      if (!ParseValue(value[index++])) {
+        return false;
+      }
+      SkipWhitespace();
+      if (_cur >= _end) {
+        return false;
+      }
+      if (*_cur == ']') {
+        _cur++;
+        return true;
+      }
+      if (*_cur != ',') {
+        return false;
+      }
+      _cur++;
+    }
+    return false;
+  }
+
+public:
+  NaClAMJsonParser(char* buffer, uint32_t len) {
+    _cur = buffer;
+    _end = buffer + len;
+    _depth = 0;
+  }
+
+  bool ParseValue(Json::Value& value) {
+    SkipWhitespace();
+    if (_cur >= _end) {
+      return false;
+    }
+    switch (*_cur) {
+      case '{':
+      case '[': {
+        if (++_depth > MAX_DEPTH) {
+          return false;
+        }
+        bool r = *_cur == '{' ? ParseObject(value) : ParseArray(value);
+        _depth--;
+        return r;
+      }
+      case '"': {
+        char* str = ParseString();
+        if (str == NULL) {
+          return false;
+        }
+        Json::StaticString staticString(str);
+        Json::Value text(staticString);
+        value.swap(text);
+        return true;
+      }
+      case 't':
+      case 'f': {
+        bool b = *_cur == 't';
+        if (!Match(b ? "true" : "false")) {
+          return false;
+        }
+        Json::Value boolean(b);
+        value.swap(boolean);
+        return true;
+      }
+      case 'n': {
+        if (!Match("null")) {
+          return false;
+        }
+        Json::Value null;
+        value.swap(null);
+        return true;
+      }
+      default:
+        return ParseNumber(value);
+    }
+  }
+
+  bool AtEnd() {
+    SkipWhitespace();
+    return _cur >= _end;
+  }
+};
+
+bool NaClAMParseJsonInPlace(char* buffer, uint32_t len, Json::Value& root) {
+  NaClAMJsonParser parser(buffer, len);
+  return parser.ParseValue(root) && parser.AtEnd();
+}
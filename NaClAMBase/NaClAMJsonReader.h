@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+#include "json/json.h"
+
+/**
+ * Parses JSON text into root without copying keys or strings. Strings are
+ * unescaped and NUL terminated inside buffer and root points into it, so
+ * buffer must stay untouched while root, or any copy of its objects, is in
+ * use. Values assigned to root later own their memory as usual.
+ * @param buffer JSON text followed by a NUL.
+ * @param len Length of the text, without the NUL.
+ * @return false when the text is not valid JSON.
+ */
+bool NaClAMParseJsonInPlace(char* buffer, uint32_t len, Json::Value& root);
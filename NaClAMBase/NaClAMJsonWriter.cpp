@@ -0,0 +1,139 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "NaClAMJsonWriter.h"
+
+static void writeUInt(std::string& out, uint64_t value) {
+  char buffer[24];
+  char* current = buffer + sizeof(buffer);
+  do {
+    *--current = char('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  out.append(current, buffer + sizeof(buffer) - current);
+}
+
+void NaClAMWriteJsonInt(std::string& out, int64_t value) {
+  if (value < 0) {
+    out += '-';
+    writeUInt(out, uint64_t(0) - uint64_t(value));
+  } else {
+    writeUInt(out, uint64_t(value));
+  }
+}
+
+/* Same digits as jsoncpp's valueToString(double): %#.16g with the trailing
+ * zeros trimmed down to one after the point. */
+static void writeReal(std::string& out, double value) {
+  if (isnan(value) || isinf(value)) {
+    out += "null";
+    return;
+  }
+  /* Whole numbers below 1e16 come out of %#.16g as their digits plus
+   * ".0", so skip snprintf for them. */
+  if (value > -1e16 && value < 1e16 && value == double(int64_t(value)) &&
+      !(value == 0.0 && signbit(value))) {
+    NaClAMWriteJsonInt(out, int64_t(value));
+    out += ".0";
+    return;
+  }
+  char buffer[32];
+  int length = snprintf(buffer, sizeof(buffer), "%#.16g", value);
+  char* ch = buffer + length - 1;
+  if (*ch == '0') {
+    while (ch > buffer && *ch == '0') {
+      --ch;
+    }
+    char* lastNonZero = ch;
+    while (ch >= buffer && *ch >= '0' && *ch <= '9') {
+      --ch;
+    }
+    if (ch >= buffer && *ch == '.') {
+      length = int(lastNonZero + 2 - buffer);
+    }
+  }
+  out.append(buffer, length);
+}
+
+void NaClAMWriteJsonString(std::string& out, const char* str) {
+  static const char hex[] = "0123456789ABCDEF";
+  out += '"';
+  const char* run = str;
+  for (const char* c = str; *c != '\0'; c++) {
+    unsigned char ch = (unsigned char)*c;
+    if (ch >= 0x20 && ch != '"' && ch != '\\') {
+      continue;
+    }
+    out.append(run, c - run);
+    run = c + 1;
+    switch (ch) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default: {
+        char escape[6] = { '\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xF] };
+        out.append(escape, sizeof(escape));
+      }
+    }
+  }
+  out.append(run, strlen(run));
+  out += '"';
+}
+
+void NaClAMWriteJson(std::string& out, const Json::Value& value) {
+  switch (value.type()) {
+    case Json::nullValue:
+      out += "null";
+      break;
+    case Json::intValue:
+      NaClAMWriteJsonInt(out, value.asLargestInt());
+      break;
+    case Json::uintValue:
+      writeUInt(out, value.asLargestUInt());
+      break;
+    case Json::realValue:
+      writeReal(out, value.asDouble());
+      break;
+    case Json::stringValue:
+      NaClAMWriteJsonString(out, value.asCString());
+      break;
+    case Json::booleanValue:
+      out += value.asBool() ? "true" : "false";
+      break;
+    case Json::arrayValue: {
+      /* Walk the members instead of indexing so each one is found without
+       * a map lookup; indices never assigned are nulls. */
+      out += '[';
+      Json::ArrayIndex next = 0;
+      for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it) {
+        Json::ArrayIndex index = it.index();
+        for (; next < index; next++) {
+          out += next ? ",null" : "null";
+        }
+        if (next++ != 0) {
+          out += ',';
+        }
+        NaClAMWriteJson(out, *it);
+      }
+      out += ']';
+      break;
+    }
+    case Json::objectValue: {
+      out += '{';
+      for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it) {
+        if (it != value.begin()) {
+          out += ',';
+        }
+        NaClAMWriteJsonString(out, it.memberName());
+        out += ':';
+        NaClAMWriteJson(out, *it);
+      }
+      out += '}';
+      break;
+    }
+  }
+}
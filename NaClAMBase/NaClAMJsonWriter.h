@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "json/json.h"
+
+/**
+ * Appends value to out as compact JSON, in the same member order as
+ * Json::FastWriter but without its per-member string copies and lookups.
+ * Non-finite reals are written as null so JSON.parse accepts them.
+ * @param out Destination, appended to and never cleared.
+ * @param value Value to write.
+ */
+void NaClAMWriteJson(std::string& out, const Json::Value& value);
+
+/**
+ * Appends str to out as a quoted and escaped JSON string.
+ * @param out Destination, appended to and never cleared.
+ * @param str Text to quote, up to its first NUL.
+ */
+void NaClAMWriteJsonString(std::string& out, const char* str);
+
+/**
+ * Appends value to out as a JSON integer.
+ */
+void NaClAMWriteJsonInt(std::string& out, int64_t value);
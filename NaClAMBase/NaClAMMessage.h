@@ -1,10 +1,17 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "json/json.h"
 
-#define MAX_FRAMES 16
+#define MAX_FRAMES 64
 struct NaClAMMessage {
+  // Members of headerRoot's objects and arrays, freed together by reset().
+  // Declared first so it outlives headerRoot.
+  Json::NodeArena headerArena;
+  // headerRoot keys and strings point into headerText, copies of headerRoot
+  // objects must not outlive the message
+  std::vector<char> headerText;
   Json::Value headerRoot;
   std::string cmdString;
   int requestId;
@@ -22,10 +29,17 @@ struct NaClAMMessage {
     frameCount = 0;
     cmdString = "";
     headerRoot.clear();
+    headerArena.release();
+    // Keeps its capacity for the next header
+    headerText.clear();
   }
 
-  void AppendFrame(PP_Var frame) {   
+  bool AppendFrame(PP_Var frame) {   
+    if (frameCount >= MAX_FRAMES) {
+      return false;
+    }
     frames[frameCount] = frame;
     frameCount++;
+    return true;
   }
 };
\ No newline at end of file
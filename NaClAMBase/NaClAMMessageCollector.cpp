@@ -1,5 +1,6 @@
 #include "NaClAMBase.h"
 #include "NaClAMMessageCollector.h"
+#include "NaClAMJsonReader.h"
 
 #define STATE_CODE_WAITING_FOR_HEADER 0
 #define STATE_CODE_COLLECTING_FRAMES 1
@@ -36,7 +37,7 @@ bool NaClAMMessageCollector::IsMessageReady() {
   return _messageReady;
 }
 
-NaClAMMessage NaClAMMessageCollector::GrabMessage() {
+const NaClAMMessage& NaClAMMessageCollector::GrabMessage() {
   _messageReady = false;
   return _preparedMessage;
 }
@@ -54,9 +55,15 @@ int NaClAMMessageCollector::ParseHeader(const char* str, uint32_t len) {
   if (len == 0) {
     return -1;
   }
-  Json::Reader reader;
+  // Parsed in place, the var's own string is read only
+  std::vector<char>& text = _preparedMessage.headerText;
+  text.assign(str, str+len);
+  text.push_back('\0');
   bool r;
-  r = reader.parse(str, str+len, _preparedMessage.headerRoot);
+  {
+    Json::NodeArena::Scope scope(_preparedMessage.headerArena);
+    r = NaClAMParseJsonInPlace(&text[0], len, _preparedMessage.headerRoot);
+  }
   if (r == false) {
     return -2;
   }
@@ -100,14 +107,21 @@ void NaClAMMessageCollector::HandleString(PP_Var message) {
     }
   } else if (_stateCode == STATE_CODE_COLLECTING_FRAMES) {
     _framesLeft--;
-    _preparedMessage.AppendFrame(message);
+    AppendFrame(message);
   }
 }
 
 void NaClAMMessageCollector::HandleBuffer(PP_Var buffer) {
   if (_stateCode == STATE_CODE_COLLECTING_FRAMES) {
     _framesLeft--;
-    _preparedMessage.AppendFrame(buffer);
+    AppendFrame(buffer);
+  }
+}
+
+void NaClAMMessageCollector::AppendFrame(PP_Var frame) {
+  if (_preparedMessage.AppendFrame(frame) == false) {
+    NaClAMPrintf("NaCl AM Error: More than %d frames, dropping frame", MAX_FRAMES);
+    moduleInterfaces.var->Release(frame);
   }
 }
 
@@ -12,6 +12,7 @@ class NaClAMMessageCollector {
   int ParseHeader(const char* str, uint32_t len);
   void HandleString(PP_Var message);
   void HandleBuffer(PP_Var buffer);
+  void AppendFrame(PP_Var frame);
 public:
   NaClAMMessageCollector();
   ~NaClAMMessageCollector();
@@ -20,6 +21,6 @@ public:
 
   void Collect(PP_Var message);
   bool IsMessageReady();
-  NaClAMMessage GrabMessage();
+  const NaClAMMessage& GrabMessage();
   void ClearMessage();
 };
\ No newline at end of file
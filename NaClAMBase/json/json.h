@@ -107,6 +107,11 @@ license you like.
 /// as if it was a POD) that may cause some validation tool to report errors.
 /// Only has effects if JSON_VALUE_USE_INTERNAL_MAP is defined.
 //#  define JSON_USE_SIMPLE_INTERNAL_ALLOCATOR 1
+/// If defined, object and array members created while a NodeArena::Scope is
+/// active on the thread are allocated from that arena and freed together when
+/// it is released, instead of one malloc and free per member.
+/// Only has effects if JSON_VALUE_USE_INTERNAL_MAP is not defined.
+#  define JSON_USE_NODE_ARENA 1
 
 // If non-zero, the library uses exceptions to report bad input instead of C
 // assertion macros. The default is to use exceptions.
@@ -328,6 +333,8 @@ namespace Json {
 #endif // if !defined(JSON_IS_AMALGAMATION)
 # include <string>
 # include <vector>
+# include <cstddef>
+# include <new>
 
 # ifndef JSON_USE_CPPTL_SMALLMAP
 #  include <map>
@@ -369,6 +376,147 @@ namespace Json {
 //   typedef CppTL::AnyEnumerator<const Value &> EnumValues;
 //# endif
 
+# if defined(JSON_USE_NODE_ARENA) && !defined(JSON_VALUE_USE_INTERNAL_MAP)
+   /** \brief Bump allocator for the members of one tree of Values.
+    *
+    * While a NodeArena::Scope is active on a thread, object and array members
+    * created on that thread are carved from the arena's blocks. Freeing such a
+    * member does nothing, release() frees them all at once, so every Value
+    * holding them must be destroyed or cleared before. Other threads, and
+    * code outside a Scope, allocate members with operator new as usual.
+    */
+   class JSON_API NodeArena
+   {
+   public:
+      NodeArena();
+      ~NodeArena();
+
+      void *allocate( size_t size );
+
+      /// Frees every block but the first, which is kept for the next tree.
+      void release();
+
+      /// Arena of the calling thread's innermost Scope, 0 when there is none.
+      static NodeArena *current();
+
+      /// Makes arena the calling thread's current arena for its lifetime.
+      class JSON_API Scope
+      {
+      public:
+         Scope( NodeArena &arena );
+         ~Scope();
+
+      private:
+         NodeArena *previous_;
+      };
+
+   private:
+      NodeArena( const NodeArena & );
+      NodeArena &operator =( const NodeArena & );
+
+      struct Block
+      {
+         Block *next_;
+         size_t size_;
+      };
+
+      Block *blocks_;
+      char *cursor_;
+      char *end_;
+   };
+
+   /** \brief STL allocator handing out single objects from the current NodeArena.
+    *
+    * Used for the nodes of the map holding array and object members. Each
+    * node is preceded by the arena it came from, 0 for nodes from operator
+    * new, so nodes may be freed outside the Scope that allocated them.
+    * Allocations of more than one object use operator new.
+    */
+   template<typename T>
+   class NodeArenaAllocator
+   {
+   public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef std::size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+      template<typename U>
+      struct rebind
+      {
+         typedef NodeArenaAllocator<U> other;
+      };
+
+      NodeArenaAllocator()
+      {
+      }
+
+      template<typename U>
+      NodeArenaAllocator( const NodeArenaAllocator<U> & )
+      {
+      }
+
+      pointer allocate( size_type count, const void * = 0 )
+      {
+         if ( count != 1 )
+            return static_cast<pointer>( ::operator new( count * sizeof(T) ) );
+         NodeArena *arena = NodeArena::current();
+         const size_type size = sizeof(Header) + sizeof(T);
+         Header *header = static_cast<Header *>( arena ? arena->allocate( size )
+                                                       : ::operator new( size ) );
+         header->arena_ = arena;
+         return reinterpret_cast<pointer>( header + 1 );
+      }
+
+      void deallocate( pointer p, size_type count )
+      {
+         if ( count != 1 )
+         {
+            ::operator delete( p );
+            return;
+         }
+         Header *header = reinterpret_cast<Header *>( p ) - 1;
+         if ( header->arena_ == 0 )
+            ::operator delete( header );
+      }
+
+      void construct( pointer p, const T &value )
+      {
+         new ( p ) T( value );
+      }
+
+      void destroy( pointer p )
+      {
+         p->~T();
+      }
+
+      size_type max_size() const
+      {
+         return size_type(-1) / sizeof(T);
+      }
+
+      bool operator ==( const NodeArenaAllocator & ) const
+      {
+         return true;
+      }
+
+      bool operator !=( const NodeArenaAllocator & ) const
+      {
+         return false;
+      }
+
+   private:
+      union Header
+      {
+         NodeArena *arena_;
+         double align_;
+      };
+   };
+# endif // if defined(JSON_USE_NODE_ARENA) && !defined(JSON_VALUE_USE_INTERNAL_MAP)
+
    /** \brief Lightweight wrapper to tag static string.
     *
     * Value constructor and objectValue member assignement takes advantage of the
@@ -506,7 +654,10 @@ namespace Json {
       };
 
    public:
-#  ifndef JSON_USE_CPPTL_SMALLMAP
+#  if defined(JSON_USE_NODE_ARENA) && !defined(JSON_USE_CPPTL_SMALLMAP)
+      typedef std::map<CZString, Value, std::less<CZString>,
+                       NodeArenaAllocator<std::pair<const CZString, Value> > > ObjectValues;
+#  elif !defined(JSON_USE_CPPTL_SMALLMAP)
       typedef std::map<CZString, Value> ObjectValues;
 #  else
       typedef CppTL::SmallMap<CZString, Value> ObjectValues;
@@ -1618,6 +1618,99 @@ const LargestInt Value::minLargestInt = LargestInt( ~(LargestUInt(-1)/2) );
 const LargestInt Value::maxLargestInt = LargestInt( LargestUInt(-1)/2 );
 const LargestUInt Value::maxLargestUInt = LargestUInt(-1);
 
+#if defined(JSON_USE_NODE_ARENA) && !defined(JSON_VALUE_USE_INTERNAL_MAP)
+# if defined(_MSC_VER)
+#  define JSON_THREAD_LOCAL __declspec(thread)
+# else
+#  define JSON_THREAD_LOCAL __thread
+# endif
+
+static JSON_THREAD_LOCAL NodeArena *currentNodeArena = 0;
+
+/// Sizes of the first block and of the largest later ones, blocks double in between
+static const size_t nodeArenaFirstBlock = 16 * 1024;
+static const size_t nodeArenaMaxBlock = 1024 * 1024;
+
+NodeArena::NodeArena()
+   : blocks_( 0 )
+   , cursor_( 0 )
+   , end_( 0 )
+{
+}
+
+
+NodeArena::~NodeArena()
+{
+   while ( blocks_ )
+   {
+      Block *next = blocks_->next_;
+      ::operator delete( blocks_ );
+      blocks_ = next;
+   }
+}
+
+
+void *
+NodeArena::allocate( size_t size )
+{
+   // Keeps every node aligned like a double
+   size = ( size + sizeof(double) - 1 ) & ~( sizeof(double) - 1 );
+   if ( size > size_t( end_ - cursor_ ) )
+   {
+      size_t blockSize = blocks_ ? blocks_->size_ * 2 : nodeArenaFirstBlock;
+      if ( blockSize > nodeArenaMaxBlock )
+         blockSize = nodeArenaMaxBlock;
+      if ( blockSize < sizeof(Block) + size )
+         blockSize = sizeof(Block) + size;
+      Block *block = static_cast<Block *>( ::operator new( blockSize ) );
+      block->next_ = blocks_;
+      block->size_ = blockSize;
+      blocks_ = block;
+      cursor_ = reinterpret_cast<char *>( block ) + sizeof(Block);
+      end_ = reinterpret_cast<char *>( block ) + blockSize;
+   }
+   void *node = cursor_;
+   cursor_ += size;
+   return node;
+}
+
+
+void
+NodeArena::release()
+{
+   if ( blocks_ == 0 )
+      return;
+   while ( blocks_->next_ )
+   {
+      Block *next = blocks_->next_;
+      ::operator delete( blocks_ );
+      blocks_ = next;
+   }
+   cursor_ = reinterpret_cast<char *>( blocks_ ) + sizeof(Block);
+   end_ = reinterpret_cast<char *>( blocks_ ) + blocks_->size_;
+}
+
+
+NodeArena *
+NodeArena::current()
+{
+   return currentNodeArena;
+}
+
+
+NodeArena::Scope::Scope( NodeArena &arena )
+   : previous_( currentNodeArena )
+{
+   currentNodeArena = &arena;
+}
+
+
+NodeArena::Scope::~Scope()
+{
+   currentNodeArena = previous_;
+}
+#endif // if defined(JSON_USE_NODE_ARENA) && !defined(JSON_VALUE_USE_INTERNAL_MAP)
+
 
 /// Unknown size marker
 static const unsigned int unknown = (unsigned)-1;
@@ -1,9 +1,22 @@
 #include <string>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <cstring>
 #include <sys/time.h>
 #include "NaClAMBase/NaClAMBase.h"
 #include "btBulletCollisionCommon.h"
 #include "btBulletDynamicsCommon.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btConvexHullComputer.h"
+#include "LinearMath/btSerializer.h"
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
+#include "BulletMultiThreaded/PosixThreadSupport.h"
+#include "BulletMultiThreaded/btParallelDbvtBroadphase.h"
+#include "BulletMultiThreaded/SpuGatheringCollisionDispatcher.h"
+#include "BulletMultiThreaded/SpuNarrowPhaseCollisionTask/SpuGatheringCollisionTask.h"
+#include "BulletWorldImporter/btBulletWorldImporter.h"
+#include "SlabAllocator.h"
 
 static uint64_t microseconds() {
   struct timeval tv;
@@ -11,8 +24,229 @@ static uint64_t microseconds() {
   return tv.tv_sec * 1000000 + tv.tv_usec;
 
 }
+
+static float profileTimeRecursive(CProfileIterator* it, const char* name, int* calls) {
+  float total = 0.0f;
+  for (int i = 0; ; i++) {
+    it->First();
+    for (int j = 0; j < i && !it->Is_Done(); j++) {
+      it->Next();
+    }
+    if (it->Is_Done()) {
+      break;
+    }
+    if (strcmp(it->Get_Current_Name(), name) == 0) {
+      total += it->Get_Current_Total_Time();
+      *calls += it->Get_Current_Total_Calls();
+    }
+    it->Enter_Child(i);
+    total += profileTimeRecursive(it, name, calls);
+    it->Enter_Parent();
+  }
+  return total;
+}
+
+/**
+ * Reads a column major 4x4 matrix stored as a JSON array of 16 numbers.
+ */
+static btTransform transformFromJson(const Json::Value& transform) {
+  btTransform T;
+  T.setIdentity();
+  if (transform.size() >= 16) {
+    float m[16];
+    for (int i = 0; i < 16; i++) {
+      m[i] = transform[i].asFloat();
+    }
+    T.setFromOpenGLMatrix(&m[0]);
+  }
+  return T;
+}
+
+/**
+ * Computes the convex hull of points, dropping interior points. When the hull
+ * has more than maxVertices vertices only the support vertices of maxVertices
+ * directions spread evenly over the sphere are kept.
+ * @param maxVertices Target vertex count, 0 keeps every hull vertex.
+ */
+static void simplifyHull(const btVector3* points, int numPoints, int maxVertices,
+                         btAlignedObjectArray<btVector3>& hullOut) {
+  btConvexHullComputer computer;
+  computer.compute(&points[0].getX(), sizeof(btVector3), numPoints, 0.0f, 0.0f);
+  const btAlignedObjectArray<btVector3>& hull = computer.vertices;
+  hullOut.clear();
+  if (maxVertices <= 0 || hull.size() <= maxVertices) {
+    hullOut = hull;
+    return;
+  }
+  std::vector<bool> taken(hull.size(), false);
+  for (int i = 0; i < maxVertices; i++) {
+    // Golden spiral
+    float z = 1.0f - (2.0f * i + 1.0f) / maxVertices;
+    float r = btSqrt(1.0f - z * z);
+    float phi = i * 2.39996323f;
+    btVector3 dir(r * btCos(phi), r * btSin(phi), z);
+    btScalar dot;
+    long index = dir.maxDot(&hull[0], hull.size(), dot);
+    if (!taken[index]) {
+      taken[index] = true;
+      hullOut.push_back(hull[index]);
+    }
+  }
+}
+
+/**
+ * Sums the time spent in every BT_PROFILE block called name since the last
+ * CProfileManager::Reset.
+ * @param calls When not NULL, receives the number of times the blocks ran.
+ * @return Time in microseconds.
+ */
+static uint64_t profileTime(const char* name, int* calls = NULL) {
+  CProfileIterator* it = CProfileManager::Get_Iterator();
+  int numCalls = 0;
+  float ms = profileTimeRecursive(it, name, &numCalls);
+  CProfileManager::Release_Iterator(it);
+  if (calls) {
+    *calls = numCalls;
+  }
+  return (uint64_t)(ms * 1000.0f);
+}
+
+/**
+ * Returns false for shapes that btBulletWorldImporter cannot rebuild from a
+ * .bullet file.
+ */
+static bool isSerializableShape(const btCollisionShape* shape) {
+  if (shape->getShapeType() == TERRAIN_SHAPE_PROXYTYPE) {
+    return false;
+  }
+  if (shape->isCompound()) {
+    const btCompoundShape* compound = (const btCompoundShape*)shape;
+    for (int i = 0; i < compound->getNumChildShapes(); i++) {
+      if (!isSerializableShape(compound->getChildShape(i))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Gives rigid bodies Bullet's default collision filter group and mask when
+ * group or mask is 0.
+ */
+static void defaultCollisionFilter(bool isDynamic, short& group, short& mask) {
+  if (group == 0) {
+    group = isDynamic ? short(btBroadphaseProxy::DefaultFilter) : short(btBroadphaseProxy::StaticFilter);
+  }
+  if (mask == 0) {
+    mask = isDynamic ? short(btBroadphaseProxy::AllFilter) : short(btBroadphaseProxy::AllFilter ^ btBroadphaseProxy::StaticFilter);
+  }
+}
+
+/**
+ * Rejects pairs whose groups and masks do not match before the pair cache
+ * stores them, like the pair cache's own test, and counts the rejections.
+ * Further rules for pairs that never need a narrowphase go here.
+ */
+class OverlapFilter : public btOverlapFilterCallback {
+public:
+  // Pair tests rejected since the last reset
+  mutable int rejectedPairs;
+
+  OverlapFilter() : rejectedPairs(0) {
+  }
+
+  virtual bool needBroadphaseCollision(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1) const {
+    bool collides = (proxy0->m_collisionFilterGroup & proxy1->m_collisionFilterMask) != 0 &&
+                    (proxy1->m_collisionFilterGroup & proxy0->m_collisionFilterMask) != 0;
+    if (!collides) {
+      rejectedPairs++;
+    }
+    return collides;
+  }
+};
+
+/**
+ * Imports .bullet files into the scene. Bodies get a motion state like the
+ * ones made by AddBody and belong to the scene, shapes and mesh data belong
+ * to the importer.
+ */
+class SceneImporter : public btBulletWorldImporter {
+public:
+  // Group and mask pairs for the bodies after the ground plane, in file
+  // order. The file format does not store them.
+  const int16_t* filters;
+  int numFilters;
+  int numBodies;
+
+  SceneImporter(btDynamicsWorld* world, const int16_t* filters, int numFilters)
+      : btBulletWorldImporter(world), filters(filters), numFilters(numFilters), numBodies(0) {
+  }
+
+  virtual btRigidBody* createRigidBody(bool isDynamic, btScalar mass,
+                                       const btTransform& startTransform,
+                                       btCollisionShape* shape, const char* bodyName) {
+    btVector3 localInertia(0,0,0);
+    if (isDynamic)
+      shape->calculateLocalInertia(mass,localInertia);
+    btDefaultMotionState* myMotionState = new btDefaultMotionState(startTransform);
+    btRigidBody::btRigidBodyConstructionInfo rbInfo(mass,myMotionState,shape,localInertia);
+    btRigidBody* body = new btRigidBody(rbInfo);
+    short group = 0;
+    short mask = 0;
+    int filter = numBodies - 1;
+    if (filter >= 0 && filter < numFilters) {
+      group = filters[filter * 2];
+      mask = filters[filter * 2 + 1];
+    }
+    defaultCollisionFilter(isDynamic, group, mask);
+    m_dynamicsWorld->addRigidBody(body, group, mask);
+    numBodies++;
+    return body;
+  }
+};
+
+/**
+ * Body states and contact manifolds of a scene. Bodies and manifolds are
+ * identified by their index in the collision object array, so a snapshot can
+ * only be restored into the scene it was taken from. Adding or removing
+ * bodies discards the scene's snapshots, as the indices no longer match.
+ */
+struct SceneSnapshot {
+  struct BodyState {
+    btTransform worldTransform;
+    btTransform interpolationWorldTransform;
+    btVector3 linearVelocity;
+    btVector3 angularVelocity;
+    btVector3 interpolationLinearVelocity;
+    btVector3 interpolationAngularVelocity;
+    btScalar deactivationTime;
+    btScalar hitFraction;
+    int activationState;
+  };
+  struct ManifoldState {
+    int body0;
+    int body1;
+    int firstContact;
+    int numContacts;
+  };
+  btAlignedObjectArray<BodyState> bodies;
+  btAlignedObjectArray<ManifoldState> manifolds;
+  // Contact points keep their cached impulses for warm starting
+  btAlignedObjectArray<btManifoldPoint> contacts;
+  unsigned long solverSeed;
+
+  int byteSize() const {
+    return bodies.size() * sizeof(BodyState) +
+           manifolds.size() * sizeof(ManifoldState) +
+           contacts.size() * sizeof(btManifoldPoint);
+  }
+};
+
 class BulletScene {
 public:
+  // Handle sent as "world" by every command for this scene
+  int worldId;
   btCollisionShape* boxShape;
   btCollisionShape* groundShape;
   int pickedObjectIndex;
@@ -24,16 +258,107 @@ public:
   btCollisionDispatcher* dispatcher;
   btBroadphaseInterface* broadphase;
   btSequentialImpulseConstraintSolver* solver;
+  btThreadSupportInterface* collisionThreadSupport;
+  // Per-thread narrowphase scratch memory, freed after the threads stop
+  std::vector<void*> collisionLocalStores;
+  btThreadSupportInterface* broadphaseThreadSupport;
+  OverlapFilter overlapFilter;
+  SceneImporter* importer;
+  std::map<int, SceneSnapshot> snapshots;
+
+  // Bodies sent by addbodies, added a few per step
+  struct PendingBody {
+    btTransform transform;
+    btCollisionShape* shape;
+    float mass;
+    float friction;
+    short group;
+    short mask;
+  };
+  btAlignedObjectArray<PendingBody> pendingBodies;
+  int nextPendingBody;
+  int addBodiesPerStep;
+  // Fixed substeps per 1/60s step
+  int substeps;
+  // Time spent in dispatchAllCollisionPairs by the last Step
+  uint64_t narrowphaseTime;
+  // Pairs the last Step handed to the batched narrowphase threads
+  int narrowphasePairs;
+  // Pairs the last Step collided on the stepping thread instead, because the
+  // batched path does not support one of their shapes
+  int narrowphaseFallbackPairs;
+  // Swept collision checks of CCD bodies in the last Step, and their time
+  int ccdSweeps;
+  uint64_t ccdTime;
+  // Time spent predicting and integrating body transforms by the last Step,
+  // not counting the CCD sweeps
+  uint64_t integrateTime;
+  // Heap allocations, frees and allocated bytes of the last Step, as counted
+  // by btAlignedAlloc on the stepping thread. Narrowphase worker threads are
+  // not counted.
+  btAlignedAllocStats stepAllocations;
+  // Sleeping settings given to dynamic bodies that do not set their own
+  double linearSleepingThreshold;
+  double angularSleepingThreshold;
+  double deactivationTime;
+  // Dynamic bodies and simulation islands awake and asleep after the last Step
+  int activeBodies;
+  int sleepingBodies;
+  int activeIslands;
+  int sleepingIslands;
+  // Per island tag marks used by CountActivity
+  btAlignedObjectArray<char> islandMarks;
 
   std::map<std::string, btCollisionShape*> shapes;
   std::map<std::string, btCollisionObject*> objectNames;
+  // Mesh interfaces and vertex, index, height and BVH data referenced by shapes
+  std::vector<btStridingMeshInterface*> meshInterfaces;
+  std::vector<void*> shapeBuffers;
 
   BulletScene() {
+    worldId = 0;
+    boxShape = NULL;
+    groundShape = NULL;
     dynamicsWorld = NULL;
     collisionConfiguration = NULL;
     dispatcher = NULL;
     broadphase = NULL;
     solver = NULL;
+    collisionThreadSupport = NULL;
+    broadphaseThreadSupport = NULL;
+    importer = NULL;
+    nextPendingBody = 0;
+    addBodiesPerStep = 500;
+    substeps = 1;
+    narrowphaseTime = 0;
+    narrowphasePairs = 0;
+    narrowphaseFallbackPairs = 0;
+    ccdSweeps = 0;
+    ccdTime = 0;
+    integrateTime = 0;
+    memset(&stepAllocations, 0, sizeof(stepAllocations));
+    linearSleepingThreshold = 0.8;
+    angularSleepingThreshold = 1.0;
+    deactivationTime = 2.0;
+    activeBodies = 0;
+    sleepingBodies = 0;
+    activeIslands = 0;
+    sleepingIslands = 0;
+  }
+
+  ~BulletScene() {
+    EmptyScene();
+    delete boxShape;
+    delete groundShape;
+  }
+
+  /**
+   * NaClAMMakeReplyObject for this scene's world.
+   */
+  Json::Value MakeReplyObject(std::string cmd, int requestId) {
+    Json::Value root = NaClAMMakeReplyObject(cmd, requestId);
+    root["world"] = Json::Value(worldId);
+    return root;
   }
 
   void Init() {
@@ -102,6 +427,11 @@ public:
       }
       removePickingConstraint();
     }
+    if (importer) {
+      importer->deleteAllData();
+      delete importer;
+      importer = NULL;
+    }
     if (dynamicsWorld) {
       delete dynamicsWorld;
       dynamicsWorld = NULL;
@@ -118,6 +448,18 @@ public:
       delete dispatcher;
       dispatcher = NULL;
     }
+    if (collisionThreadSupport) {
+      delete collisionThreadSupport;
+      collisionThreadSupport = NULL;
+    }
+    for (size_t i = 0; i < collisionLocalStores.size(); i++) {
+      deleteCollisionLocalStoreMemory(collisionLocalStores[i]);
+    }
+    collisionLocalStores.clear();
+    if (broadphaseThreadSupport) {
+      delete broadphaseThreadSupport;
+      broadphaseThreadSupport = NULL;
+    }
     if (collisionConfiguration) {
       delete collisionConfiguration;
       collisionConfiguration = NULL;
@@ -129,8 +471,21 @@ public:
       it++;
     }
     shapes.clear();
+    for (size_t i = 0; i < meshInterfaces.size(); i++) {
+      delete meshInterfaces[i];
+    }
+    meshInterfaces.clear();
+    for (size_t i = 0; i < shapeBuffers.size(); i++) {
+      btAlignedFree(shapeBuffers[i]);
+    }
+    shapeBuffers.clear();
     // Clear name table
     objectNames.clear();
+    snapshots.clear();
+    pendingBodies.clear();
+    nextPendingBody = 0;
+    // Give the slabs this scene emptied back to the system
+    slabAllocatorTrim();
   }
 
   void AddGroundPlane() {
@@ -148,16 +503,103 @@ public:
     dynamicsWorld->addRigidBody(body);
   }
 
-  void ResetScene() {
+  /**
+   * @param narrowphaseThreads When greater than zero the frame's overlapping
+   * pairs are gathered into batches and processed on that many threads.
+   * Convex hulls are collided there against a copy of their points with a
+   * linear support search, not the data optimizeSupportQueries builds, and
+   * hulls of more than MAX_NUM_SPU_CONVEX_POINTS points, also inside
+   * compounds, are collided on the stepping thread. sceneupdate reports
+   * those pairs as narrowphasefallbackpairs.
+   * @param broadphaseThreads When greater than zero the broadphase searches
+   * the dynamic tree for overlaps on that many threads.
+   * @param groundPlane Adds the ground plane as the first object.
+   */
+  void ResetScene(int narrowphaseThreads, int broadphaseThreads,
+                  bool groundPlane = true) {
     EmptyScene();
     collisionConfiguration = new btDefaultCollisionConfiguration();
-    dispatcher = new      btCollisionDispatcher(collisionConfiguration);
-    broadphase = new btDbvtBroadphase();
+    if (narrowphaseThreads > 0) {
+      PosixThreadSupport::ThreadConstructionInfo constructionInfo("collision",
+                                                                  processCollisionTask,
+                                                                  createCollisionLocalStoreMemory,
+                                                                  narrowphaseThreads);
+      collisionThreadSupport = new PosixThreadSupport(constructionInfo);
+      for (int i = 0; i < narrowphaseThreads; i++) {
+        collisionLocalStores.push_back(collisionThreadSupport->getThreadLocalMemory(i));
+      }
+      dispatcher = new SpuGatheringCollisionDispatcher(collisionThreadSupport,
+                                                       narrowphaseThreads,
+                                                       collisionConfiguration);
+    } else {
+      dispatcher = new btCollisionDispatcher(collisionConfiguration);
+    }
+    if (broadphaseThreads > 0) {
+      PosixThreadSupport::ThreadConstructionInfo constructionInfo("broadphase",
+                                                                  DbvtCollideThreadFunc,
+                                                                  DbvtCollidelsMemoryFunc,
+                                                                  broadphaseThreads);
+      broadphaseThreadSupport = new PosixThreadSupport(constructionInfo);
+      broadphase = new btParallelDbvtBroadphase(broadphaseThreadSupport);
+    } else {
+      broadphase = new btDbvtBroadphase();
+    }
     solver = new btSequentialImpulseConstraintSolver();
     dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher,
                                                 broadphase,
                                                 solver,collisionConfiguration);
-    AddGroundPlane();
+    broadphase->getOverlappingPairCache()->setOverlapFilterCallback(&overlapFilter);
+    overlapFilter.rejectedPairs = 0;
+    if (groundPlane) {
+      AddGroundPlane();
+    }
+  }
+
+  /**
+   * Replaces the scene with the contents of a .bullet file made by
+   * SaveBinary, so the ground plane comes first.
+   * @return false when the file could not be read.
+   */
+  bool LoadBinary(const void* data, uint32_t byteLength, int narrowphaseThreads,
+                  int broadphaseThreads, const int16_t* filters, int numFilters) {
+    ResetScene(narrowphaseThreads, broadphaseThreads, false);
+    // The parser may byte swap in place, keep the caller's copy intact
+    char* copy = (char*)btAlignedAlloc(byteLength, 16);
+    memcpy(copy, data, byteLength);
+    importer = new SceneImporter(dynamicsWorld, filters, numFilters);
+    bool ok = importer->loadFileFromMemory(copy, byteLength);
+    btAlignedFree(copy);
+    for (int i = 0; i < importer->getNumCollisionShapes(); i++) {
+      btCollisionShape* shape = importer->getCollisionShapeByIndex(i);
+      if (shape->getShapeType() == CONVEX_HULL_SHAPE_PROXYTYPE) {
+        ((btConvexHullShape*)shape)->optimizeSupportQueries();
+      }
+    }
+    return ok && dynamicsWorld->getNumCollisionObjects() > 0;
+  }
+
+  /**
+   * Serializes the world, shapes and BVHs included, into a .bullet file.
+   * @return NULL when a shape cannot be imported again, otherwise a buffer
+   * the caller frees with btAlignedFree.
+   */
+  void* SaveBinary(uint32_t* byteLength) {
+    *byteLength = 0;
+    if (!dynamicsWorld) {
+      return NULL;
+    }
+    for (int i = 0; i < dynamicsWorld->getNumCollisionObjects(); i++) {
+      btCollisionObject* obj = dynamicsWorld->getCollisionObjectArray()[i];
+      if (!isSerializableShape(obj->getCollisionShape())) {
+        return NULL;
+      }
+    }
+    btDefaultSerializer serializer;
+    dynamicsWorld->serialize(&serializer);
+    *byteLength = serializer.getCurrentBufferSize();
+    void* blob = btAlignedAlloc(*byteLength, 16);
+    memcpy(blob, serializer.getBufferPointer(), *byteLength);
+    return blob;
   }
 
   void AddBox(const btTransform& T, float mass) {
@@ -171,7 +613,205 @@ public:
       dynamicsWorld->addRigidBody(body);
   }
 
-  void AddShape(const Json::Value& shape) {
+  /**
+   * Copies the ArrayBuffer frame of message numbered frameIndex into 16 byte
+   * aligned memory that lives as long as the scene.
+   * @return NULL when there is no such frame.
+   */
+  void* CopyFrame(const NaClAMMessage& message, const Json::Value& frameIndex,
+                  uint32_t* byteLength) {
+    int frame = frameIndex.isNull() ? -1 : frameIndex.asInt();
+    *byteLength = 0;
+    if (frame < 0 || frame >= message.frameCount ||
+        message.frames[frame].type != PP_VARTYPE_ARRAY_BUFFER ||
+        !moduleInterfaces.varArrayBuffer->ByteLength(message.frames[frame], byteLength) ||
+        *byteLength == 0) {
+      return NULL;
+    }
+    void* copy = btAlignedAlloc(*byteLength, 16);
+    const void* data = moduleInterfaces.varArrayBuffer->Map(message.frames[frame]);
+    memcpy(copy, data, *byteLength);
+    moduleInterfaces.varArrayBuffer->Unmap(message.frames[frame]);
+    shapeBuffers.push_back(copy);
+    return copy;
+  }
+
+  /**
+   * Checks a BVH blob loaded in place against the mesh it was sent with, so a
+   * stale or malformed blob is rebuilt instead of traversed.
+   * @param numTriangles The triangles of the mesh's single part.
+   * @param meshMin The mesh's bounding box, which the quantization bounds
+   * must cover.
+   */
+  static bool IsBvhUsable(btOptimizedBvh* bvh, int numTriangles,
+                          const btVector3& meshMin, const btVector3& meshMax) {
+    if (!bvh->isQuantized()) {
+      return false;
+    }
+    const btVector3& aabbMin = bvh->getQuantizationAabbMin();
+    const btVector3& aabbMax = bvh->getQuantizationAabbMax();
+    const btVector3& quantization = bvh->getQuantization();
+    for (int axis = 0; axis < 3; axis++) {
+      // Negated so NaNs fail too
+      if (!(aabbMin[axis] <= meshMin[axis] && aabbMax[axis] >= meshMax[axis] &&
+            quantization[axis] > 0.0f &&
+            (aabbMax[axis] - aabbMin[axis]) * quantization[axis] <= 65535.0f)) {
+        return false;
+      }
+    }
+    QuantizedNodeArray& nodes = bvh->getQuantizedNodeArray();
+    int numNodes = nodes.size();
+    // A binary tree over numTriangles leaves has 2 * numTriangles - 1 nodes
+    if (numNodes != 2 * numTriangles - 1) {
+      return false;
+    }
+    // Each internal node's escape index spans the node and its two children's
+    // subtrees back to back, and the root spans the whole array. Leaves
+    // reference a triangle of part 0.
+    for (int i = 0; i < numNodes; i++) {
+      const btQuantizedBvhNode& node = nodes[i];
+      if (node.isLeafNode()) {
+        if (node.getPartId() != 0 || node.getTriangleIndex() >= numTriangles) {
+          return false;
+        }
+        continue;
+      }
+      int span = node.getEscapeIndex();
+      if (span < 3 || span > numNodes - i || (i == 0 && span != numNodes)) {
+        return false;
+      }
+      int left = i + 1;
+      int leftSpan = nodes[left].isLeafNode() ? 1 : nodes[left].getEscapeIndex();
+      if (leftSpan < 1 || leftSpan > span - 2) {
+        return false;
+      }
+      int right = left + leftSpan;
+      int rightSpan = nodes[right].isLeafNode() ? 1 : nodes[right].getEscapeIndex();
+      if (1 + leftSpan + rightSpan != span) {
+        return false;
+      }
+    }
+    // The subtree headers are walked by the cache friendly traversal and the
+    // threaded narrowphase
+    BvhSubtreeInfoArray& subtrees = bvh->getSubtreeInfoArray();
+    for (int i = 0; i < subtrees.size(); i++) {
+      int root = subtrees[i].m_rootNodeIndex;
+      int size = subtrees[i].m_subtreeSize;
+      if (root < 0 || root >= numNodes || size < 1 || size > numNodes - root) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Builds a static triangle mesh from float xyz vertices and int32 triangle
+   * indices. A BVH blob previously returned in a bvhbuilt message is loaded
+   * in place, otherwise the BVH is built and optionally sent back to JS.
+   */
+  btCollisionShape* AddTriangleMesh(const Json::Value& shape, const NaClAMMessage& message) {
+    std::string name = shape["name"].asString();
+    uint32_t verticesLength = 0;
+    uint32_t indicesLength = 0;
+    float* vertices = (float*)CopyFrame(message, shape["verticesFrame"], &verticesLength);
+    int* indices = (int*)CopyFrame(message, shape["indicesFrame"], &indicesLength);
+    int numVertices = verticesLength / (3 * sizeof(float));
+    int numTriangles = indicesLength / (3 * sizeof(int));
+    if (vertices == NULL || indices == NULL || numVertices == 0 || numTriangles == 0) {
+      NaClAMLogError("Triangle mesh %s needs verticesFrame and indicesFrame\n", name.c_str());
+      return NULL;
+    }
+    for (int i = 0; i < numTriangles * 3; i++) {
+      if (indices[i] < 0 || indices[i] >= numVertices) {
+        NaClAMLogError("Triangle mesh %s has an index out of range\n", name.c_str());
+        return NULL;
+      }
+    }
+    btTriangleIndexVertexArray* meshInterface =
+        new btTriangleIndexVertexArray(numTriangles, indices, 3 * sizeof(int),
+                                       numVertices, vertices, 3 * sizeof(float));
+    meshInterfaces.push_back(meshInterface);
+
+    btOptimizedBvh* bvh = NULL;
+    uint32_t bvhLength = 0;
+    void* bvhData = CopyFrame(message, shape["bvhFrame"], &bvhLength);
+    if (bvhData) {
+      bvh = (btOptimizedBvh*)btOptimizedBvh::deSerializeInPlace(bvhData, bvhLength, false);
+      if (bvh) {
+        btVector3 meshMin(vertices[0], vertices[1], vertices[2]);
+        btVector3 meshMax = meshMin;
+        for (int i = 1; i < numVertices; i++) {
+          btVector3 vertex(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+          meshMin.setMin(vertex);
+          meshMax.setMax(vertex);
+        }
+        if (!IsBvhUsable(bvh, numTriangles, meshMin, meshMax)) {
+          bvh = NULL;
+        }
+      }
+      if (bvh == NULL) {
+        NaClAMLogWarning("Triangle mesh %s has a stale BVH, rebuilding\n", name.c_str());
+      }
+    }
+    btBvhTriangleMeshShape* trimesh = new btBvhTriangleMeshShape(meshInterface, true, bvh == NULL);
+    if (bvh) {
+      trimesh->setOptimizedBvh(bvh);
+    } else if (shape["exportBvh"].asBool()) {
+      const btOptimizedBvh* builtBvh = trimesh->getOptimizedBvh();
+      uint32_t size = builtBvh->calculateSerializeBufferSize();
+      void* serialized = btAlignedAlloc(size, 16);
+      builtBvh->serialize(serialized, size, false);
+      PP_Var blob = moduleInterfaces.varArrayBuffer->Create(size);
+      memcpy(moduleInterfaces.varArrayBuffer->Map(blob), serialized, size);
+      moduleInterfaces.varArrayBuffer->Unmap(blob);
+      btAlignedFree(serialized);
+      Json::Value root = MakeReplyObject("bvhbuilt", message.requestId);
+      root["shape"] = Json::Value(name);
+      NaClAMSendMessage(root, &blob, 1);
+      moduleInterfaces.var->Release(blob);
+    }
+    return trimesh;
+  }
+
+  /**
+   * Builds a static heightfield from width * length float heights, row by
+   * row. Like btHeightfieldTerrainShape it is centred on its bounding box.
+   */
+  btCollisionShape* AddHeightfield(const Json::Value& shape, const NaClAMMessage& message) {
+    std::string name = shape["name"].asString();
+    int width = shape["width"].asInt();
+    int length = shape["length"].asInt();
+    uint32_t heightsLength = 0;
+    float* heights = (float*)CopyFrame(message, shape["heightsFrame"], &heightsLength);
+    // In 64 bit math, so a large width or length can not wrap the product
+    // below heightsLength. heightsLength bounds the product by 2^30.
+    if (heights == NULL || width < 2 || length < 2 ||
+        (uint64_t)width * (uint64_t)length * sizeof(float) > heightsLength) {
+      NaClAMLogError("Heightfield %s needs width * length heights in heightsFrame\n", name.c_str());
+      return NULL;
+    }
+    float minHeight = heights[0];
+    float maxHeight = heights[0];
+    for (int i = 1; i < width * length; i++) {
+      minHeight = btMin(minHeight, heights[i]);
+      maxHeight = btMax(maxHeight, heights[i]);
+    }
+    btHeightfieldTerrainShape* heightfield =
+        new btHeightfieldTerrainShape(width, length, heights, 1.0f, minHeight, maxHeight,
+                                      1, PHY_FLOAT, false);
+    if (shape.isMember("spacing")) {
+      float spacing = shape["spacing"].asFloat();
+      heightfield->setLocalScaling(btVector3(spacing, 1.0f, spacing));
+    }
+    return heightfield;
+  }
+
+  /**
+   * @param shape The JSON shape description.
+   * @param message The message carrying the scene, for shapes whose data
+   * arrives in binary frames.
+   */
+  void AddShape(const Json::Value& shape, const NaClAMMessage& message) {
     Json::Value name = shape["name"];
     Json::Value type = shape["type"];
 
@@ -188,6 +828,10 @@ public:
       bulletShape = new btBoxShape(halfExtents);
     } else if (shapeType.compare("convex") == 0) {
       Json::Value points = shape["points"];
+      // Optional: reduce the hull to this many vertices
+      int maxVertices = shape["maxVertices"].asInt();
+      // Optional: precompute faces for one-shot polyhedral contact clipping
+      bool polyhedral = shape["polyhedral"].asBool();
       int numPoints = points.size();
       if (numPoints > 0) {
         btVector3* convexHull = new btVector3[numPoints];
@@ -196,7 +840,24 @@ public:
           convexHull[i][1] = points[i][1].asFloat();
           convexHull[i][2] = points[i][2].asFloat();
         }
-        bulletShape = new btConvexHullShape(&convexHull[0][0], numPoints);
+        btConvexHullShape* hullShape = NULL;
+        if (maxVertices > 0 || polyhedral) {
+          btAlignedObjectArray<btVector3> hull;
+          simplifyHull(convexHull, numPoints, maxVertices, hull);
+          if (hull.size() > 0) {
+            hullShape = new btConvexHullShape(&hull[0][0], hull.size());
+          }
+        }
+        if (hullShape == NULL) {
+          hullShape = new btConvexHullShape(&convexHull[0][0], numPoints);
+        }
+        delete [] convexHull;
+        // SIMD point scan, and hill-climbing support queries for large hulls
+        hullShape->optimizeSupportQueries();
+        if (polyhedral) {
+          hullShape->initializePolyhedralFeatures();
+        }
+        bulletShape = hullShape;
       }
     } else if (shapeType.compare("sphere") == 0) {
       Json::Value radius = shape["radius"];
@@ -206,19 +867,75 @@ public:
       Json::Value height = shape["height"];
       btVector3 halfExtents = btVector3(radius.asFloat(), height.asFloat()*0.5f, 0.0f);
       bulletShape = new btCylinderShape(halfExtents);
+    } else if (shapeType.compare("compound") == 0) {
+      // Children refer to shapes defined earlier in the scene. Their
+      // transforms are either inline or packed as 16 floats per child in
+      // the frame given by transformsFrame.
+      const Json::Value& children = shape["children"];
+      int numChildren = children.size();
+      const float* packedTransforms = NULL;
+      PP_Var transformsVar;
+      if (shape.isMember("transformsFrame")) {
+        int frame = shape["transformsFrame"].asInt();
+        uint32_t byteLength = 0;
+        if (frame < 0 || frame >= message.frameCount ||
+            message.frames[frame].type != PP_VARTYPE_ARRAY_BUFFER ||
+            !moduleInterfaces.varArrayBuffer->ByteLength(message.frames[frame], &byteLength) ||
+            byteLength < numChildren * 16 * sizeof(float)) {
+          NaClAMLogError("Compound %s has an invalid transformsFrame\n", name.asString().c_str());
+          return;
+        }
+        transformsVar = message.frames[frame];
+        packedTransforms = (const float*)moduleInterfaces.varArrayBuffer->Map(transformsVar);
+      }
+      // The children are kept in a dynamic AABB tree, so compound versus
+      // compound collisions only test overlapping child pairs.
+      btCompoundShape* compound = new btCompoundShape(true);
+      for (int i = 0; i < numChildren; i++) {
+        std::string childName = children[i]["shape"].asString();
+        if (shapes.count(childName) == 0) {
+          NaClAMLogError("Could not find child shape %s of %s\n", childName.c_str(), name.asString().c_str());
+          continue;
+        }
+        btTransform T;
+        if (packedTransforms) {
+          T.setFromOpenGLMatrix(&packedTransforms[i*16]);
+        } else {
+          T = transformFromJson(children[i]["transform"]);
+        }
+        compound->addChildShape(T, shapes[childName]);
+      }
+      if (packedTransforms) {
+        moduleInterfaces.varArrayBuffer->Unmap(transformsVar);
+      }
+      if (compound->getNumChildShapes() == 0) {
+        delete compound;
+      } else {
+        bulletShape = compound;
+      }
+    } else if (shapeType.compare("trimesh") == 0) {
+      bulletShape = AddTriangleMesh(shape, message);
+    } else if (shapeType.compare("heightfield") == 0) {
+      bulletShape = AddHeightfield(shape, message);
     } else {
-      NaClAMPrintf("Could not load shape type %s\n", shapeType.c_str());
+      NaClAMLogError("Could not load shape type %s\n", shapeType.c_str());
       return;
     }
 
     if (bulletShape == NULL) {
-      NaClAMPrintf("Could not build shape %s\n", name.asString().c_str());
+      NaClAMLogError("Could not build shape %s\n", name.asString().c_str());
       return;
     }
 
     shapes[name.asString()] = bulletShape;
+  }
 
-    NaClAMPrintf("Added shape %s of %s\n", name.asString().c_str(), type.asString().c_str());
+  btCollisionShape* FindShape(const std::string& shapeName) {
+    if (shapes.count(shapeName) == 0) {
+      NaClAMLogWarning("Could not find shape %s defaulting to unit cube.", shapeName.c_str());
+      return boxShape;
+    }
+    return shapes[shapeName];
   }
 
   void AddBody(const Json::Value& bodyDesc) {
@@ -226,23 +943,38 @@ public:
     float mass = bodyDesc["mass"].asFloat();
     float friction = bodyDesc["friction"].asFloat();
     Json::Value transform = bodyDesc["transform"];
-    btCollisionShape* shape = boxShape;
-    if (shapes.count(shapeName) == 0) {
-      NaClAMPrintf("Could not find shape %s defaulting to unit cube.", shapeName.c_str());
-    } else {
-      shape = shapes[shapeName];
+    btCollisionShape* shape = FindShape(shapeName);
+    btTransform T = transformFromJson(transform);
+    // Bodies only collide when each one's group is in the other's mask
+    short group = (short)bodyDesc["group"].asInt();
+    short mask = (short)bodyDesc["mask"].asInt();
+    btRigidBody* body = AddRigidBody(shape, T, mass, friction, group, mask);
+    if (bodyDesc.isMember("linearSleepingThreshold") || bodyDesc.isMember("angularSleepingThreshold")) {
+      body->setSleepingThresholds(bodyDesc.get("linearSleepingThreshold", linearSleepingThreshold).asFloat(),
+                                  bodyDesc.get("angularSleepingThreshold", angularSleepingThreshold).asFloat());
     }
+    if (bodyDesc.isMember("deactivationTime")) {
+      body->setDeactivationTimeThreshold(bodyDesc["deactivationTime"].asFloat());
+    }
+    // Bodies moving further than ccdMotionThreshold in a substep are swept
+    // as a sphere of ccdSweptSphereRadius, so small fast bodies do not pass
+    // through others between substeps
+    if (bodyDesc.isMember("ccdMotionThreshold")) {
+      body->setCcdMotionThreshold(bodyDesc["ccdMotionThreshold"].asFloat());
+      body->setCcdSweptSphereRadius(bodyDesc["ccdSweptSphereRadius"].asFloat());
+    }
+  }
 
-    btTransform T;
-    T.setIdentity();
-    {
-      float m[16];
-      for (int i = 0; i < transform.size(); i++) {
-        m[i] = transform[i].asFloat();
-      }
-      T.setFromOpenGLMatrix(&m[0]);
+  /**
+   * @param group Collision filter group, or 0 for Bullet's default.
+   * @param mask Collision filter mask, or 0 for Bullet's default.
+   */
+  btRigidBody* AddRigidBody(btCollisionShape* shape, const btTransform& T, float mass, float friction,
+                            short group = 0, short mask = 0) {
+    if (shape->isConcave() && mass != 0.f) {
+      NaClAMLogError("Concave shapes can only be used by static bodies.");
+      mass = 0.f;
     }
-    
 
     bool isDynamic = (mass != 0.f);
     btVector3 localInertia(0,0,0);
@@ -252,24 +984,450 @@ public:
     btRigidBody::btRigidBodyConstructionInfo rbInfo(mass,myMotionState,shape,localInertia);
     btRigidBody* body = new btRigidBody(rbInfo);
     body->setFriction(friction);
-    dynamicsWorld->addRigidBody(body);
+    if (isDynamic) {
+      body->setSleepingThresholds(linearSleepingThreshold, angularSleepingThreshold);
+      body->setDeactivationTimeThreshold(deactivationTime);
+    }
+    defaultCollisionFilter(isDynamic, group, mask);
+    dynamicsWorld->addRigidBody(body, group, mask);
+    return body;
+  }
+
+  /**
+   * Reads the world's sleeping settings from a scene description or
+   * setsleeping arguments. Missing settings get Bullet's defaults.
+   */
+  void SetSleeping(const Json::Value& args) {
+    linearSleepingThreshold = args.get("linearSleepingThreshold", 0.8).asDouble();
+    angularSleepingThreshold = args.get("angularSleepingThreshold", 1.0).asDouble();
+    deactivationTime = args.get("deactivationTime", 2.0).asDouble();
+  }
+
+  /**
+   * Gives every dynamic body the world's deactivation time and, when
+   * thresholds is set, its sleeping thresholds as well.
+   */
+  void ApplySleeping(bool thresholds) {
+    btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+    for (int i = 1; i < objects.size(); i++) {
+      btRigidBody* body = btRigidBody::upcast(objects[i]);
+      if (!body || body->isStaticOrKinematicObject()) {
+        continue;
+      }
+      if (thresholds) {
+        body->setSleepingThresholds(linearSleepingThreshold, angularSleepingThreshold);
+      }
+      body->setDeactivationTimeThreshold(deactivationTime);
+    }
+  }
+
+  /**
+   * Counts dynamic bodies and simulation islands that are awake and asleep.
+   * Island tags are only assigned while stepping, so bodies added since the
+   * last step have none and count as bodies but not islands.
+   */
+  void CountActivity() {
+    activeBodies = 0;
+    sleepingBodies = 0;
+    activeIslands = 0;
+    sleepingIslands = 0;
+    btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+    // Tags are union find roots, which are indices into objects
+    islandMarks.resize(objects.size());
+    for (int i = 0; i < islandMarks.size(); i++) {
+      islandMarks[i] = 0;
+    }
+    for (int i = 1; i < objects.size(); i++) {
+      btCollisionObject* obj = objects[i];
+      if (obj->isStaticOrKinematicObject()) {
+        continue;
+      }
+      bool sleeping = obj->getActivationState() == ISLAND_SLEEPING;
+      if (sleeping) {
+        sleepingBodies++;
+      } else {
+        activeBodies++;
+      }
+      int tag = obj->getIslandTag();
+      if (tag < 0 || tag >= islandMarks.size() || islandMarks[tag]) {
+        continue;
+      }
+      islandMarks[tag] = 1;
+      if (sleeping) {
+        sleepingIslands++;
+      } else {
+        activeIslands++;
+      }
+    }
+  }
+
+  /**
+   * Stops every awake dynamic body and puts it to sleep, except bodies that
+   * disable deactivation such as the picked one.
+   * @return The number of bodies put to sleep.
+   */
+  int ForceSleep() {
+    int count = 0;
+    btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+    for (int i = 1; i < objects.size(); i++) {
+      btRigidBody* body = btRigidBody::upcast(objects[i]);
+      if (!body || body->isStaticOrKinematicObject()) {
+        continue;
+      }
+      int state = body->getActivationState();
+      if (state == ISLAND_SLEEPING || state == DISABLE_DEACTIVATION || state == DISABLE_SIMULATION) {
+        continue;
+      }
+      body->setLinearVelocity(btVector3(0,0,0));
+      body->setAngularVelocity(btVector3(0,0,0));
+      body->setActivationState(ISLAND_SLEEPING);
+      count++;
+    }
+    return count;
+  }
+
+  /**
+   * Captures the state of every body and the contact points of every
+   * manifold into snapshot.
+   */
+  void TakeSnapshot(SceneSnapshot& snapshot) {
+    snapshot.bodies.clear();
+    snapshot.manifolds.clear();
+    snapshot.contacts.clear();
+    snapshot.solverSeed = solver->getRandSeed();
+    btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+    std::map<const btCollisionObject*, int> indices;
+    snapshot.bodies.resize(objects.size());
+    for (int i = 0; i < objects.size(); i++) {
+      btCollisionObject* obj = objects[i];
+      SceneSnapshot::BodyState& state = snapshot.bodies[i];
+      indices[obj] = i;
+      state.worldTransform = obj->getWorldTransform();
+      state.interpolationWorldTransform = obj->getInterpolationWorldTransform();
+      state.interpolationLinearVelocity = obj->getInterpolationLinearVelocity();
+      state.interpolationAngularVelocity = obj->getInterpolationAngularVelocity();
+      state.deactivationTime = obj->getDeactivationTime();
+      state.hitFraction = obj->getHitFraction();
+      state.activationState = obj->getActivationState();
+      btRigidBody* body = btRigidBody::upcast(obj);
+      if (body) {
+        state.linearVelocity = body->getLinearVelocity();
+        state.angularVelocity = body->getAngularVelocity();
+      }
+    }
+    for (int i = 0; i < dispatcher->getNumManifolds(); i++) {
+      btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+      if (manifold->getNumContacts() == 0) {
+        continue;
+      }
+      SceneSnapshot::ManifoldState state;
+      state.body0 = indices[manifold->getBody0()];
+      state.body1 = indices[manifold->getBody1()];
+      state.firstContact = snapshot.contacts.size();
+      state.numContacts = manifold->getNumContacts();
+      for (int j = 0; j < manifold->getNumContacts(); j++) {
+        snapshot.contacts.push_back(manifold->getContactPoint(j));
+      }
+      snapshot.manifolds.push_back(state);
+    }
+  }
+
+  /**
+   * Puts every body back in the state captured by TakeSnapshot, without
+   * recreating bodies. Overlapping pairs are rebuilt from the restored
+   * bounding boxes and manifolds get the snapshot's contact points back, so
+   * the next step is warm started like the step that followed the snapshot.
+   * @return false when the snapshot does not match the scene's bodies.
+   */
+  bool RestoreSnapshot(const SceneSnapshot& snapshot) {
+    btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+    if (snapshot.bodies.size() != objects.size()) {
+      return false;
+    }
+    removePickingConstraint();
+    for (int i = 0; i < objects.size(); i++) {
+      btCollisionObject* obj = objects[i];
+      const SceneSnapshot::BodyState& state = snapshot.bodies[i];
+      obj->setWorldTransform(state.worldTransform);
+      obj->setInterpolationWorldTransform(state.interpolationWorldTransform);
+      obj->setInterpolationLinearVelocity(state.interpolationLinearVelocity);
+      obj->setInterpolationAngularVelocity(state.interpolationAngularVelocity);
+      obj->setDeactivationTime(state.deactivationTime);
+      obj->setHitFraction(state.hitFraction);
+      obj->forceActivationState(state.activationState);
+      btRigidBody* body = btRigidBody::upcast(obj);
+      if (body) {
+        body->setLinearVelocity(state.linearVelocity);
+        body->setAngularVelocity(state.angularVelocity);
+        body->updateInertiaTensor();
+        body->clearForces();
+        if (body->getMotionState()) {
+          body->getMotionState()->setWorldTransform(state.worldTransform);
+        }
+      }
+    }
+    // Rebuild the broadphase in object order so that every restore of this
+    // snapshot leads to the same pair and manifold order
+    btAlignedObjectArray<btBroadphaseProxy*> proxies;
+    for (int i = 0; i < objects.size(); i++) {
+      dynamicsWorld->updateSingleAabb(objects[i]);
+      proxies.push_back(objects[i]->getBroadphaseHandle());
+    }
+    ((btDbvtBroadphase*)broadphase)->rebuild(&proxies[0], proxies.size(), dispatcher);
+    dispatcher->dispatchAllCollisionPairs(broadphase->getOverlappingPairCache(),
+                                          dynamicsWorld->getDispatchInfo(), dispatcher);
+
+    std::map<std::pair<int, int>, int> manifoldIndices;
+    for (int i = 0; i < snapshot.manifolds.size(); i++) {
+      const SceneSnapshot::ManifoldState& state = snapshot.manifolds[i];
+      manifoldIndices[std::make_pair(state.body0, state.body1)] = i;
+    }
+    std::map<const btCollisionObject*, int> indices;
+    for (int i = 0; i < objects.size(); i++) {
+      indices[objects[i]] = i;
+    }
+    for (int i = 0; i < dispatcher->getNumManifolds(); i++) {
+      btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+      std::pair<int, int> key(indices[manifold->getBody0()], indices[manifold->getBody1()]);
+      manifold->clearManifold();
+      std::map<std::pair<int, int>, int>::iterator it = manifoldIndices.find(key);
+      if (it == manifoldIndices.end()) {
+        continue;
+      }
+      const SceneSnapshot::ManifoldState& state = snapshot.manifolds[it->second];
+      manifold->setNumContacts(state.numContacts);
+      for (int j = 0; j < state.numContacts; j++) {
+        manifold->getContactPoint(j) = snapshot.contacts[state.firstContact + j];
+      }
+    }
+    solver->setRandSeed(snapshot.solverSeed);
+    return true;
+  }
+
+  /**
+   * Queues bodies stored as 18 floats each: mass, friction and a column
+   * major 4x4 transform.
+   * @return The number of bodies queued.
+   */
+  int QueueBodies(btCollisionShape* shape, const float* data, int numBodies,
+                  short group, short mask) {
+    for (int i = 0; i < numBodies; i++) {
+      const float* record = &data[i * 18];
+      PendingBody& pending = pendingBodies.expandNonInitializing();
+      pending.shape = shape;
+      pending.group = group;
+      pending.mask = mask;
+      pending.mass = record[0];
+      pending.friction = record[1];
+      pending.transform.setFromOpenGLMatrix(&record[2]);
+    }
+    return numBodies;
+  }
+
+  int NumPendingBodies() const {
+    return pendingBodies.size() - nextPendingBody;
   }
 
-  void Step() {
-    if (dynamicsWorld)
-      dynamicsWorld->stepSimulation(1.0/60.0);
+  /**
+   * Adds at most addBodiesPerStep queued bodies.
+   * @return The number of bodies added.
+   */
+  int AddPendingBodies() {
+    int count = btMin(NumPendingBodies(), addBodiesPerStep);
+    if (count > 0) {
+      snapshots.clear();
+    }
+    for (int i = 0; i < count; i++) {
+      const PendingBody& pending = pendingBodies[nextPendingBody++];
+      AddRigidBody(pending.shape, pending.transform, pending.mass, pending.friction,
+                   pending.group, pending.mask);
+    }
+    if (NumPendingBodies() == 0) {
+      pendingBodies.clear();
+      nextPendingBody = 0;
+    }
+    return count;
+  }
+
+  /**
+   * Removes the body at index by moving the last body into its place.
+   * @return The index the moved body had, or -1 when nothing was removed.
+   */
+  int RemoveBody(int index) {
+    btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+    if (index <= 0 || index >= objects.size()) {
+      return -1;
+    }
+    btCollisionObject* obj = objects[index];
+    btRigidBody* body = btRigidBody::upcast(obj);
+    if (body && body == pickedBody) {
+      removePickingConstraint();
+    }
+    if (body && body->getMotionState()) {
+      delete body->getMotionState();
+    }
+    int last = objects.size() - 1;
+    dynamicsWorld->removeCollisionObject(obj);
+    delete obj;
+    if (pickedObjectIndex == last) {
+      pickedObjectIndex = index;
+    }
+    // The last body moved into index
+    snapshots.clear();
+    return last;
+  }
+
+  /**
+   * Safe to call on any thread, as long as nothing else uses this scene
+   * meanwhile. The profile it reads narrowphaseTime from is per thread.
+   * @return The number of queued bodies added before stepping.
+   */
+  int Step() {
+    int added = 0;
+    if (dynamicsWorld) {
+      btAlignedAllocStats before;
+      btAlignedAllocGetThreadStats(&before);
+      CProfileManager::Reset();
+      overlapFilter.rejectedPairs = 0;
+      btDbvtBroadphase* dbvt = (btDbvtBroadphase*)broadphase;
+      dbvt->m_moves_call = 0;
+      dbvt->m_moves_skipped = 0;
+      // A batch at least as large as the dynamic tree is collided in one
+      // tree against tree pass in the step's broadphase update instead of
+      // one query per insertion. That pass covers every dynamic proxy, so
+      // smaller batches keep the per insertion queries.
+      bool deferredCollide = dbvt->m_deferedcollide;
+      if (NumPendingBodies() > 0) {
+        int batch = btMin(NumPendingBodies(), addBodiesPerStep);
+        if (batch >= dbvt->m_sets[btDbvtBroadphase::DYNAMIC_SET].m_leaves) {
+          dbvt->m_deferedcollide = true;
+        }
+        added = AddPendingBodies();
+      }
+      SpuGatheringCollisionDispatcher* batched = NULL;
+      if (collisionThreadSupport) {
+        batched = (SpuGatheringCollisionDispatcher*)dispatcher;
+        batched->resetNumBatchedPairs();
+      }
+      dynamicsWorld->stepSimulation(1.0/60.0, substeps, 1.0/(60.0*substeps));
+      dbvt->m_deferedcollide = deferredCollide;
+      narrowphaseTime = profileTime("dispatchAllCollisionPairs");
+      narrowphasePairs = batched ? batched->getNumBatchedPairs() : 0;
+      narrowphaseFallbackPairs = batched ? batched->getNumFallbackPairs() : 0;
+      ccdTime = profileTime("CCD motion clamping", &ccdSweeps);
+      integrateTime = profileTime("predictUnconstraintMotion") + profileTime("integrateTransforms");
+      integrateTime -= btMin(integrateTime, ccdTime);
+      CountActivity();
+      btAlignedAllocGetThreadStats(&stepAllocations);
+      stepAllocations.m_numAllocs -= before.m_numAllocs;
+      stepAllocations.m_numFrees -= before.m_numFrees;
+      stepAllocations.m_numBytes -= before.m_numBytes;
+    }
+    return added;
   }
 };
 
-static BulletScene scene;
+// Independent scenes by world handle. World 0 always exists and is the one
+// used by commands without a "world" argument.
+static std::map<int, BulletScene*> worlds;
+static int nextWorldId = 1;
+
+/**
+ * One world's share of a stepscene command.
+ */
+struct StepTask {
+  BulletScene* scene;
+  int addedBodies;
+  uint64_t simTime;
+};
+
+// Threads stepping worlds in parallel, created by the first stepscene that
+// asks for stepThreads. The pool only grows, up to kMaxStepThreads, so it is
+// not torn down when the number of worlds changes.
+static const int kMaxStepThreads = 8;
+static PosixThreadSupport* stepThreadSupport = NULL;
+static int numStepThreads = 0;
+
+static void stepWorldTask(void* userPtr, void* lsMemory) {
+  StepTask* task = (StepTask*)userPtr;
+  uint64_t start = microseconds();
+  task->addedBodies = task->scene->Step();
+  task->simTime = microseconds() - start;
+}
+
+static void* createStepLocalStoreMemory() {
+  return NULL;
+}
+
+static bool moreObjects(const StepTask* a, const StepTask* b) {
+  return a->scene->dynamicsWorld->getNumCollisionObjects() >
+         b->scene->dynamicsWorld->getNumCollisionObjects();
+}
+
+/**
+ * Steps every task's scene. With more than one task and threads > 0 the
+ * scenes step at the same time on up to threads threads, largest first, so
+ * small worlds are not held up behind large ones. threads is clamped to the
+ * number of tasks and to kMaxStepThreads.
+ */
+static void stepWorlds(std::vector<StepTask>& tasks, int threads) {
+  threads = btMin(threads, btMin((int)tasks.size(), kMaxStepThreads));
+  if (threads <= 1) {
+    for (size_t i = 0; i < tasks.size(); i++) {
+      stepWorldTask(&tasks[i], NULL);
+    }
+    return;
+  }
+  if (numStepThreads < threads) {
+    delete stepThreadSupport;
+    PosixThreadSupport::ThreadConstructionInfo constructionInfo("worldstep",
+                                                                stepWorldTask,
+                                                                createStepLocalStoreMemory,
+                                                                threads);
+    stepThreadSupport = new PosixThreadSupport(constructionInfo);
+    numStepThreads = threads;
+  }
+  std::vector<StepTask*> order(tasks.size());
+  for (size_t i = 0; i < tasks.size(); i++) {
+    order[i] = &tasks[i];
+  }
+  std::stable_sort(order.begin(), order.end(), moreObjects);
+  // Command 1 runs the thread function on the given task, as for the
+  // narrowphase and the parallel solver
+  size_t next = 0;
+  int busy = 0;
+  for (int t = 0; t < threads && next < order.size(); t++) {
+    stepThreadSupport->sendRequest(1, (ppu_address_t)order[next++], t);
+    busy++;
+  }
+  while (busy > 0) {
+    unsigned int taskId = 0;
+    unsigned int status = 0;
+    stepThreadSupport->waitForResponse(&taskId, &status);
+    busy--;
+    if (next < order.size()) {
+      stepThreadSupport->sendRequest(1, (ppu_address_t)order[next++], taskId);
+      busy++;
+    }
+  }
+}
+
+static BulletScene* findWorld(int worldId) {
+  std::map<int, BulletScene*>::iterator it = worlds.find(worldId);
+  return it == worlds.end() ? NULL : (*it).second;
+}
 
 /**
  * This function is called at module initialization time.
  * moduleInterfaces and moduleInstance are already initialized.
  */
 void NaClAMModuleInit() {
-  NaClAMPrintf("Bullet AM Running.");
-  scene.Init();
+  // Before anything allocates through btAlignedAlloc
+  slabAllocatorInstall();
+  NaClAMLogInfo("Bullet AM Running.");
+  BulletScene* scene = new BulletScene();
+  scene->Init();
+  worlds[0] = scene;
 }
 
 /**
@@ -280,60 +1438,367 @@ void NaClAMModuleHeartBeat(uint64_t microseconds) {
 
 }
 
-void handleLoadScene(const NaClAMMessage& message) {
-  scene.ResetScene();
+void handleLoadScene(BulletScene& scene, const NaClAMMessage& message) {
+  uint64_t start = microseconds();
   const Json::Value& root = message.headerRoot;
   const Json::Value& sceneDesc = root["args"];
+  scene.ResetScene(sceneDesc["narrowphaseThreads"].asInt(),
+                   sceneDesc["broadphaseThreads"].asInt());
+  scene.substeps = btMax(1, sceneDesc["substeps"].asInt());
+  ((btDiscreteDynamicsWorld*)scene.dynamicsWorld)->setBatchedIntegration(sceneDesc["batchedIntegration"].asBool());
+  ((btDbvtBroadphase*)scene.broadphase)->setMargin(sceneDesc.get("broadphaseMargin", DBVT_BP_MARGIN).asDouble());
+  scene.SetSleeping(sceneDesc);
   const Json::Value& shapes = sceneDesc["shapes"];
   const Json::Value& bodies = sceneDesc["bodies"];
   int numShapes = shapes.size();
 
   for (int i = 0; i < numShapes; i++) {
-    scene.AddShape(shapes[i]);
+    scene.AddShape(shapes[i], message);
   }
 
   int numBodies = bodies.size();
   for (int i = 0; i < numBodies; i++) {
     scene.AddBody(bodies[i]);
   }
+  uint64_t end = microseconds();
   
   // Scene created.
   {
-    Json::Value root = NaClAMMakeReplyObject("sceneloaded", message.requestId);
+    Json::Value root = scene.MakeReplyObject("sceneloaded", message.requestId);
     root["sceneobjectcount"] = Json::Value(numBodies);
+    root["loadtime"] = Json::Value((Json::UInt64)(end-start));
+    root["format"] = Json::Value("json");
     NaClAMSendMessage(root, NULL, 0);
   }
 }
 
-void handleStepScene(const NaClAMMessage& message) {
-  if (scene.dynamicsWorld == NULL ||
-      scene.dynamicsWorld->getNumCollisionObjects() == 1) {
-    // No scene, just send a reply
-    Json::Value root = NaClAMMakeReplyObject("noscene", message.requestId);
+/**
+ * Loads a .bullet file sent in the frame numbered sceneFrame. The file is
+ * normally one returned by savescenebinary, which skips parsing JSON shape
+ * data and rebuilding hulls and BVHs. Collision filters are not part of the
+ * file, they may be sent as int16 group and mask pairs in filtersFrame.
+ */
+void handleLoadSceneBinary(BulletScene& scene, const NaClAMMessage& message) {
+  uint64_t start = microseconds();
+  const Json::Value& args = message.headerRoot["args"];
+  int frame = args["sceneFrame"].asInt();
+  uint32_t byteLength = 0;
+  bool ok = false;
+  if (frame >= 0 && frame < message.frameCount &&
+      message.frames[frame].type == PP_VARTYPE_ARRAY_BUFFER &&
+      moduleInterfaces.varArrayBuffer->ByteLength(message.frames[frame], &byteLength) &&
+      byteLength > 0) {
+    // Optional collision filter group and mask of each body as int16 pairs
+    int filtersFrame = args.isMember("filtersFrame") ? args["filtersFrame"].asInt() : -1;
+    const int16_t* filters = NULL;
+    uint32_t filtersLength = 0;
+    if (filtersFrame >= 0 && filtersFrame < message.frameCount &&
+        message.frames[filtersFrame].type == PP_VARTYPE_ARRAY_BUFFER &&
+        moduleInterfaces.varArrayBuffer->ByteLength(message.frames[filtersFrame], &filtersLength)) {
+      filters = (const int16_t*)moduleInterfaces.varArrayBuffer->Map(message.frames[filtersFrame]);
+    }
+    const void* data = moduleInterfaces.varArrayBuffer->Map(message.frames[frame]);
+    ok = scene.LoadBinary(data, byteLength, args["narrowphaseThreads"].asInt(),
+                          args["broadphaseThreads"].asInt(),
+                          filters, filtersLength / (2 * sizeof(int16_t)));
+    moduleInterfaces.varArrayBuffer->Unmap(message.frames[frame]);
+    if (filters) {
+      moduleInterfaces.varArrayBuffer->Unmap(message.frames[filtersFrame]);
+    }
+  }
+  if (!ok) {
+    NaClAMLogError("Could not load binary scene.");
+    scene.ResetScene(args["narrowphaseThreads"].asInt(),
+                     args["broadphaseThreads"].asInt());
+  }
+  scene.substeps = btMax(1, args["substeps"].asInt());
+  ((btDiscreteDynamicsWorld*)scene.dynamicsWorld)->setBatchedIntegration(args["batchedIntegration"].asBool());
+  ((btDbvtBroadphase*)scene.broadphase)->setMargin(args.get("broadphaseMargin", DBVT_BP_MARGIN).asDouble());
+  scene.SetSleeping(args);
+  // Sleeping thresholds are stored per body in the file, deactivation
+  // times are not
+  scene.ApplySleeping(false);
+  uint64_t end = microseconds();
+  {
+    Json::Value root = scene.MakeReplyObject("sceneloaded", message.requestId);
+    root["sceneobjectcount"] = Json::Value(scene.dynamicsWorld->getNumCollisionObjects()-1);
+    root["loadtime"] = Json::Value((Json::UInt64)(end-start));
+    root["format"] = Json::Value("bullet");
+    NaClAMSendMessage(root, NULL, 0);
+  }
+}
+
+/**
+ * Converts the current scene into a .bullet file and sends it back in a
+ * scenebinary message. Scenes with heightfields cannot be converted.
+ */
+void handleSaveSceneBinary(BulletScene& scene, const NaClAMMessage& message) {
+  uint64_t start = microseconds();
+  uint32_t byteLength = 0;
+  void* blob = scene.SaveBinary(&byteLength);
+  uint64_t end = microseconds();
+  Json::Value root = scene.MakeReplyObject("scenebinary", message.requestId);
+  if (blob == NULL) {
+    root["error"] = Json::Value("Scene cannot be converted.");
     NaClAMSendMessage(root, NULL, 0);
     return;
   }
-  {
-    Json::Value rayTo = message.headerRoot["args"]["rayTo"];
-    float x = rayTo[0].asFloat();
-    float y = rayTo[1].asFloat();
-    float z = rayTo[2].asFloat();
-    Json::Value rayFrom = message.headerRoot["args"]["rayFrom"];
-    float cx = rayFrom[0].asFloat();
-    float cy = rayFrom[1].asFloat();
-    float cz = rayFrom[2].asFloat();
-    scene.movePickingConstraint(btVector3(cx, cy, cz), btVector3(x,y,z));
+  root["savetime"] = Json::Value((Json::UInt64)(end-start));
+  PP_Var file = moduleInterfaces.varArrayBuffer->Create(byteLength);
+  memcpy(moduleInterfaces.varArrayBuffer->Map(file), blob, byteLength);
+  moduleInterfaces.varArrayBuffer->Unmap(file);
+  btAlignedFree(blob);
+  NaClAMSendMessage(root, &file, 1);
+  moduleInterfaces.var->Release(file);
+}
+
+/**
+ * Snapshots the scene into the numbered slot, replacing what it held.
+ */
+void handleSnapshot(BulletScene& scene, const NaClAMMessage& message) {
+  if (!scene.dynamicsWorld) {
+    return;
   }
+  int slot = message.headerRoot["args"]["slot"].asInt();
+  uint64_t start = microseconds();
+  SceneSnapshot& snapshot = scene.snapshots[slot];
+  scene.TakeSnapshot(snapshot);
+  uint64_t end = microseconds();
+  Json::Value root = scene.MakeReplyObject("snapshottaken", message.requestId);
+  root["slot"] = Json::Value(slot);
+  root["snapshotsize"] = Json::Value(snapshot.byteSize());
+  root["snapshottime"] = Json::Value((Json::UInt64)(end-start));
+  NaClAMSendMessage(root, NULL, 0);
+}
 
+/**
+ * Restores the scene from the numbered slot. The slot is kept so it can be
+ * restored again.
+ */
+void handleRestore(BulletScene& scene, const NaClAMMessage& message) {
+  if (!scene.dynamicsWorld) {
+    return;
+  }
+  int slot = message.headerRoot["args"]["slot"].asInt();
+  Json::Value root = scene.MakeReplyObject("restored", message.requestId);
+  root["slot"] = Json::Value(slot);
   uint64_t start = microseconds();
-  // Do work
-  scene.Step();
+  if (scene.snapshots.count(slot) == 0 || !scene.RestoreSnapshot(scene.snapshots[slot])) {
+    root["error"] = Json::Value("No snapshot of this scene in slot.");
+    NaClAMSendMessage(root, NULL, 0);
+    return;
+  }
   uint64_t end = microseconds();
-  uint64_t delta = end-start;
-  {
+  root["restoretime"] = Json::Value((Json::UInt64)(end-start));
+  NaClAMSendMessage(root, NULL, 0);
+}
+
+/**
+ * Changes the world's sleeping thresholds and deactivation time and gives
+ * them to every dynamic body, replacing per body settings.
+ */
+void handleSetSleeping(BulletScene& scene, const NaClAMMessage& message) {
+  if (!scene.dynamicsWorld) {
+    return;
+  }
+  scene.SetSleeping(message.headerRoot["args"]);
+  scene.ApplySleeping(true);
+  Json::Value root = scene.MakeReplyObject("sleepingset", message.requestId);
+  root["linearsleepingthreshold"] = Json::Value(scene.linearSleepingThreshold);
+  root["angularsleepingthreshold"] = Json::Value(scene.angularSleepingThreshold);
+  root["deactivationtime"] = Json::Value(scene.deactivationTime);
+  NaClAMSendMessage(root, NULL, 0);
+}
+
+/**
+ * Steps the scene without sending updates until every dynamic body sleeps
+ * or maxSteps steps have run, then puts the bodies still awake to sleep.
+ */
+void handleSettle(BulletScene& scene, const NaClAMMessage& message) {
+  if (!scene.dynamicsWorld) {
+    return;
+  }
+  const Json::Value& args = message.headerRoot["args"];
+  int maxSteps = args.get("maxSteps", 600).asInt();
+  uint64_t start = microseconds();
+  scene.CountActivity();
+  int steps = 0;
+  while (steps < maxSteps && (scene.activeBodies > 0 || scene.NumPendingBodies() > 0)) {
+    scene.Step();
+    steps++;
+  }
+  int forced = scene.ForceSleep();
+  scene.CountActivity();
+  uint64_t end = microseconds();
+  Json::Value root = scene.MakeReplyObject("settled", message.requestId);
+  root["steps"] = Json::Value(steps);
+  root["forced"] = Json::Value(forced);
+  root["activebodies"] = Json::Value(scene.activeBodies);
+  root["sleepingbodies"] = Json::Value(scene.sleepingBodies);
+  root["settletime"] = Json::Value((Json::UInt64)(end-start));
+  NaClAMSendMessage(root, NULL, 0);
+}
+
+/**
+ * Queues bodies that all use the named shape. They are sent in the frame
+ * numbered bodiesFrame, 18 floats per body: mass, friction and a column
+ * major 4x4 transform. Queued bodies are added over the following steps,
+ * at most perStep of them per step, with the collision filter group and
+ * mask given.
+ */
+void handleAddBodies(BulletScene& scene, const NaClAMMessage& message) {
+  if (!scene.dynamicsWorld) {
+    return;
+  }
+  const Json::Value& args = message.headerRoot["args"];
+  int frame = args["bodiesFrame"].asInt();
+  uint32_t byteLength = 0;
+  int queued = 0;
+  if (frame >= 0 && frame < message.frameCount &&
+      message.frames[frame].type == PP_VARTYPE_ARRAY_BUFFER &&
+      moduleInterfaces.varArrayBuffer->ByteLength(message.frames[frame], &byteLength)) {
+    btCollisionShape* shape = scene.FindShape(args["shape"].asString());
+    const float* data = (const float*)moduleInterfaces.varArrayBuffer->Map(message.frames[frame]);
+    queued = scene.QueueBodies(shape, data, byteLength / (18 * sizeof(float)),
+                               (short)args["group"].asInt(), (short)args["mask"].asInt());
+    moduleInterfaces.varArrayBuffer->Unmap(message.frames[frame]);
+  }
+  if (args.isMember("perStep")) {
+    scene.addBodiesPerStep = btMax(1, args["perStep"].asInt());
+  }
+  Json::Value root = scene.MakeReplyObject("bodiesqueued", message.requestId);
+  root["queued"] = Json::Value(queued);
+  root["pendingbodies"] = Json::Value(scene.NumPendingBodies());
+  NaClAMSendMessage(root, NULL, 0);
+}
+
+/**
+ * Removes the bodies with the given object table indices, in order. Each
+ * removal moves the last body into the freed index, the reply lists the
+ * removed indices and the [from, to] index of each moved body.
+ */
+void handleRemoveBodies(BulletScene& scene, const NaClAMMessage& message) {
+  if (!scene.dynamicsWorld) {
+    return;
+  }
+  Json::Value root = scene.MakeReplyObject("bodiesremoved", message.requestId);
+  if (scene.NumPendingBodies() > 0) {
+    // Object table indices of queued bodies are not settled yet
+    root["error"] = Json::Value("Bodies are still being added.");
+    NaClAMSendMessage(root, NULL, 0);
+    return;
+  }
+  const Json::Value& indices = message.headerRoot["args"]["indices"];
+  Json::Value removed(Json::arrayValue);
+  Json::Value moved(Json::arrayValue);
+  for (unsigned int i = 0; i < indices.size(); i++) {
+    int index = indices[i].asInt();
+    int from = scene.RemoveBody(index + 1);
+    if (from < 0) {
+      continue;
+    }
+    removed.append(Json::Value(index));
+    if (from != index + 1) {
+      Json::Value move(Json::arrayValue);
+      move.append(Json::Value(from - 1));
+      move.append(Json::Value(index));
+      moved.append(move);
+    }
+  }
+  root["removed"] = removed;
+  root["moved"] = moved;
+  NaClAMSendMessage(root, NULL, 0);
+}
+
+/**
+ * Steps the world given by "world", or each world listed in "worlds". With
+ * stepThreads > 1 the listed worlds step in parallel on that many threads,
+ * at most one per world and kMaxStepThreads in all.
+ * Every world stepped gets its own sceneupdate or noscene reply. A world
+ * listed more than once is stepped and answered once.
+ */
+void handleStepScene(const NaClAMMessage& message) {
+  const Json::Value& args = message.headerRoot["args"];
+  Json::Value rayTo = args["rayTo"];
+  float x = rayTo[0].asFloat();
+  float y = rayTo[1].asFloat();
+  float z = rayTo[2].asFloat();
+  Json::Value rayFrom = args["rayFrom"];
+  float cx = rayFrom[0].asFloat();
+  float cy = rayFrom[1].asFloat();
+  float cz = rayFrom[2].asFloat();
+
+  std::vector<int> worldIds;
+  if (args.isMember("worlds")) {
+    const Json::Value& ids = args["worlds"];
+    for (unsigned int i = 0; i < ids.size(); i++) {
+      // Two tasks for one world would step it concurrently
+      int id = ids[i].asInt();
+      if (std::find(worldIds.begin(), worldIds.end(), id) == worldIds.end()) {
+        worldIds.push_back(id);
+      }
+    }
+  } else {
+    worldIds.push_back(args["world"].asInt());
+  }
+  std::vector<StepTask> tasks;
+  for (size_t i = 0; i < worldIds.size(); i++) {
+    BulletScene* scene = findWorld(worldIds[i]);
+    if (scene == NULL) {
+      Json::Value root = NaClAMMakeReplyObject("noworld", message.requestId);
+      root["world"] = Json::Value(worldIds[i]);
+      NaClAMSendMessage(root, NULL, 0);
+      continue;
+    }
+    if (scene->dynamicsWorld == NULL ||
+        (scene->dynamicsWorld->getNumCollisionObjects() == 1 &&
+         scene->NumPendingBodies() == 0)) {
+      // No scene, just send a reply
+      Json::Value root = scene->MakeReplyObject("noscene", message.requestId);
+      NaClAMSendMessage(root, NULL, 0);
+      continue;
+    }
+    scene->movePickingConstraint(btVector3(cx, cy, cz), btVector3(x,y,z));
+    StepTask task;
+    task.scene = scene;
+    task.addedBodies = 0;
+    task.simTime = 0;
+    tasks.push_back(task);
+  }
+
+  // Do work
+  stepWorlds(tasks, args["stepThreads"].asInt());
+
+  for (size_t t = 0; t < tasks.size(); t++) {
+    BulletScene& scene = *tasks[t].scene;
     // Build headers
-    Json::Value root = NaClAMMakeReplyObject("sceneupdate", message.requestId);
-    root["simtime"] = Json::Value(delta);
+    Json::Value root = scene.MakeReplyObject("sceneupdate", message.requestId);
+    root["simtime"] = Json::Value((Json::UInt64)tasks[t].simTime);
+    root["addedbodies"] = Json::Value(tasks[t].addedBodies);
+    root["pendingbodies"] = Json::Value(scene.NumPendingBodies());
+    // Narrowphase throughput. The time includes the fallback pairs
+    // collided on the stepping thread, so the rate counts them too.
+    int numPairs = scene.narrowphasePairs + scene.narrowphaseFallbackPairs;
+    uint64_t narrowphaseTime = scene.narrowphaseTime;
+    root["narrowphasepairs"] = Json::Value(scene.narrowphasePairs);
+    root["narrowphasefallbackpairs"] = Json::Value(scene.narrowphaseFallbackPairs);
+    root["narrowphasetime"] = Json::Value((Json::UInt64)narrowphaseTime);
+    if (numPairs > 0 && narrowphaseTime > 0) {
+      root["narrowphasepairspersecond"] = Json::Value(numPairs * 1000000.0 / narrowphaseTime);
+    }
+    root["rejectedpairs"] = Json::Value(scene.overlapFilter.rejectedPairs);
+    // Share of aabb updates that stayed inside their proxy's enlarged aabb
+    root["broadphaseskipped"] = Json::Value(((btDbvtBroadphase*)scene.broadphase)->getSkippedMoves());
+    root["activebodies"] = Json::Value(scene.activeBodies);
+    root["sleepingbodies"] = Json::Value(scene.sleepingBodies);
+    root["activeislands"] = Json::Value(scene.activeIslands);
+    root["sleepingislands"] = Json::Value(scene.sleepingIslands);
+    root["ccdsweeps"] = Json::Value(scene.ccdSweeps);
+    root["ccdtime"] = Json::Value((Json::UInt64)scene.ccdTime);
+    root["integratetime"] = Json::Value((Json::UInt64)scene.integrateTime);
+    root["allocations"] = Json::Value(scene.stepAllocations.m_numAllocs);
+    root["frees"] = Json::Value(scene.stepAllocations.m_numFrees);
+    root["allocatedbytes"] = Json::Value((Json::UInt64)scene.stepAllocations.m_numBytes);
     // Build transform frame
     int numObjects = scene.dynamicsWorld->getNumCollisionObjects();
     uint32_t TransformSize = (numObjects-1)*4*4*sizeof(float);
@@ -357,7 +1822,7 @@ void handleStepScene(const NaClAMMessage& message) {
   }
 }
 
-void handlePickObject(const NaClAMMessage& message) {
+void handlePickObject(BulletScene& scene, const NaClAMMessage& message) {
   if (!scene.dynamicsWorld) {
     return;
   }
@@ -380,12 +1845,70 @@ void handlePickObject(const NaClAMMessage& message) {
   }
   scene.pickedObjectIndex = index;
   scene.addPickingConstraint(btVector3(cx, cy, cz), btVector3(x,y,z));
-  NaClAMPrintf("Picked %d\n", scene.pickedObjectIndex);
+  NaClAMLogDebug("Picked %d\n", scene.pickedObjectIndex);
 }
 
-void handleDropObject(const NaClAMMessage& message) {
+void handleDropObject(BulletScene& scene, const NaClAMMessage& message) {
   scene.removePickingConstraint();
-  NaClAMPrintf("Dropped %d\n", scene.pickedObjectIndex);
+  NaClAMLogDebug("Dropped %d\n", scene.pickedObjectIndex);
+}
+
+/**
+ * Creates an empty world and replies with its handle.
+ */
+void handleCreateWorld(const NaClAMMessage& message) {
+  BulletScene* scene = new BulletScene();
+  scene->Init();
+  scene->worldId = nextWorldId++;
+  worlds[scene->worldId] = scene;
+  Json::Value root = scene->MakeReplyObject("worldcreated", message.requestId);
+  NaClAMSendMessage(root, NULL, 0);
+}
+
+/**
+ * Destroys a world made by createworld. World 0 cannot be destroyed.
+ */
+void handleDestroyWorld(const NaClAMMessage& message) {
+  int worldId = message.headerRoot["args"]["world"].asInt();
+  Json::Value root = NaClAMMakeReplyObject("worlddestroyed", message.requestId);
+  root["world"] = Json::Value(worldId);
+  BulletScene* scene = findWorld(worldId);
+  if (scene == NULL || worldId == 0) {
+    root["error"] = Json::Value("No world to destroy.");
+    NaClAMSendMessage(root, NULL, 0);
+    return;
+  }
+  worlds.erase(worldId);
+  delete scene;
+  NaClAMSendMessage(root, NULL, 0);
+}
+
+/**
+ * Reports heap use of all worlds. allocationspersecond covers the time since
+ * the previous memstats, or since the module started.
+ */
+void handleMemStats(const NaClAMMessage& message) {
+  static uint64_t lastTime = 0;
+  static uint64_t lastAllocations = 0;
+  SlabAllocatorStats stats;
+  slabAllocatorGetStats(&stats);
+  uint64_t now = microseconds();
+  double allocationsPerSecond = 0.0;
+  if (lastTime != 0 && now > lastTime) {
+    allocationsPerSecond = double(stats.allocations - lastAllocations) * 1000000.0 / double(now - lastTime);
+  }
+  lastTime = now;
+  lastAllocations = stats.allocations;
+  Json::Value root = NaClAMMakeReplyObject("memstats", message.requestId);
+  root["livebytes"] = Json::Value((Json::Int64)stats.liveBytes);
+  root["peakbytes"] = Json::Value((Json::Int64)stats.peakBytes);
+  root["slabbytes"] = Json::Value((Json::Int64)stats.slabBytes);
+  root["largebytes"] = Json::Value((Json::Int64)stats.largeBytes);
+  root["allocations"] = Json::Value((Json::UInt64)stats.allocations);
+  root["frees"] = Json::Value((Json::UInt64)stats.frees);
+  root["allocationspersecond"] = Json::Value(allocationsPerSecond);
+  root["threadcaches"] = Json::Value(stats.threadCaches);
+  NaClAMSendMessage(root, NULL, 0);
 }
 
 /**
@@ -393,13 +1916,53 @@ void handleDropObject(const NaClAMMessage& message) {
  * @param message A complete message sent from JS
  */
 void NaClAMModuleHandleMessage(const NaClAMMessage& message) {
-  if (message.cmdString.compare("loadscene") == 0) {
-    handleLoadScene(message);
-  } else if (message.cmdString.compare("stepscene") == 0) {
+  if (message.cmdString.compare("createworld") == 0) {
+    handleCreateWorld(message);
+    return;
+  }
+  if (message.cmdString.compare("destroyworld") == 0) {
+    handleDestroyWorld(message);
+    return;
+  }
+  if (message.cmdString.compare("stepscene") == 0) {
+    // May step several worlds
     handleStepScene(message);
+    return;
+  }
+  if (message.cmdString.compare("memstats") == 0) {
+    handleMemStats(message);
+    return;
+  }
+  int worldId = message.headerRoot["args"]["world"].asInt();
+  BulletScene* world = findWorld(worldId);
+  if (world == NULL) {
+    Json::Value root = NaClAMMakeReplyObject("noworld", message.requestId);
+    root["world"] = Json::Value(worldId);
+    NaClAMSendMessage(root, NULL, 0);
+    return;
+  }
+  BulletScene& scene = *world;
+  if (message.cmdString.compare("loadscene") == 0) {
+    handleLoadScene(scene, message);
+  } else if (message.cmdString.compare("loadscenebinary") == 0) {
+    handleLoadSceneBinary(scene, message);
+  } else if (message.cmdString.compare("savescenebinary") == 0) {
+    handleSaveSceneBinary(scene, message);
+  } else if (message.cmdString.compare("snapshot") == 0) {
+    handleSnapshot(scene, message);
+  } else if (message.cmdString.compare("restore") == 0) {
+    handleRestore(scene, message);
+  } else if (message.cmdString.compare("addbodies") == 0) {
+    handleAddBodies(scene, message);
+  } else if (message.cmdString.compare("removebodies") == 0) {
+    handleRemoveBodies(scene, message);
+  } else if (message.cmdString.compare("setsleeping") == 0) {
+    handleSetSleeping(scene, message);
+  } else if (message.cmdString.compare("settle") == 0) {
+    handleSettle(scene, message);
   } else if (message.cmdString.compare("pickobject") == 0) {
-    handlePickObject(message);
+    handlePickObject(scene, message);
   } else if (message.cmdString.compare("dropobject") == 0) {
-    handleDropObject(message);
+    handleDropObject(scene, message);
   }
 }
\ No newline at end of file
@@ -3,15 +3,251 @@ function NaClAMBulletInit() {
 	aM.addEventListener('sceneloaded', NaClAMBulletSceneLoadedHandler);
 	aM.addEventListener('noscene', NaClAMBulletStepSceneHandler);
 	aM.addEventListener('sceneupdate', NaClAMBulletStepSceneHandler);
+	aM.addEventListener('bvhbuilt', NaClAMBulletBvhBuiltHandler);
+	aM.addEventListener('scenebinary', NaClAMBulletSceneBinaryHandler);
+	aM.addEventListener('snapshottaken', NaClAMBulletSnapshotHandler);
+	aM.addEventListener('restored', NaClAMBulletRestoredHandler);
+	aM.addEventListener('bodiesremoved', NaClAMBulletBodiesRemovedHandler);
+	aM.addEventListener('sleepingset', NaClAMBulletSleepingSetHandler);
+	aM.addEventListener('settled', NaClAMBulletSettledHandler);
+	aM.addEventListener('worldcreated', NaClAMBulletWorldHandler);
+	aM.addEventListener('worlddestroyed', NaClAMBulletWorldHandler);
+	aM.addEventListener('noworld', NaClAMBulletWorldHandler);
+	aM.addEventListener('memstats', NaClAMBulletMemStatsHandler);
+}
+
+// Every command takes an optional world argument, a handle returned in
+// worldcreated. World 0 always exists, it is the one rendered here.
+function NaClAMBulletCreateWorld() {
+	aM.sendMessage('createworld', {});
+}
+
+function NaClAMBulletDestroyWorld(world) {
+	aM.sendMessage('destroyworld', {world: world});
+}
+
+function NaClAMBulletWorldHandler(msg) {
+	if (msg.header.error != undefined) {
+		console.log('World ' + msg.header.world + ': ' + msg.header.error);
+		return;
+	}
+	console.log(msg.header.cmd + ' ' + msg.header.world);
+}
+
+// Heap use of the whole module, it takes no world argument. The rate counts
+// allocations since the previous memstats.
+function NaClAMBulletMemStats() {
+	aM.sendMessage('memstats', {});
+}
+
+function NaClAMBulletMemStatsHandler(msg) {
+	console.log('Heap: ' + msg.header.livebytes + ' bytes live, ' + msg.header.peakbytes + ' peak, ' + msg.header.slabbytes + ' in slabs, ' +
+		msg.header.largebytes + ' in large blocks, ' + Math.round(msg.header.allocationspersecond) + ' allocations per second, ' +
+		msg.header.threadcaches + ' thread caches');
+}
+
+// Binary shape data (typed arrays or ArrayBuffers) cannot travel in the JSON
+// header. Each one is sent as a frame and its key is replaced by
+// key + 'Frame', holding the frame index. Typed arrays must span their buffer.
+function NaClAMBulletPackFrames(sceneDescription, frames) {
+	var packed = {};
+	var key;
+	for (key in sceneDescription) {
+		if (key != 'binary') {
+			packed[key] = sceneDescription[key];
+		}
+	}
+	if (sceneDescription.shapes == undefined) {
+		return packed;
+	}
+	packed.shapes = [];
+	for (var i = 0; i < sceneDescription.shapes.length; i++) {
+		var shape = sceneDescription.shapes[i];
+		var packedShape = {};
+		for (key in shape) {
+			var value = shape[key];
+			if (value instanceof ArrayBuffer) {
+				packedShape[key + 'Frame'] = frames.length;
+				frames.push(value);
+			} else if (value && value.buffer instanceof ArrayBuffer) {
+				packedShape[key + 'Frame'] = frames.length;
+				frames.push(value.buffer);
+			} else {
+				packedShape[key] = value;
+			}
+		}
+		packed.shapes.push(packedShape);
+	}
+	return packed;
 }
 
 function NaClAMBulletLoadScene(sceneDescription) {
-	aM.sendMessage('loadscene', sceneDescription);
+	var frames = [];
+	var packed = NaClAMBulletPackFrames(sceneDescription, frames);
+	aM.sendMessage('loadscene', packed, frames);
+}
+
+// Loads the .bullet file cached by NaClAMBulletSceneBinaryHandler instead of
+// building the scene from its JSON description.
+function NaClAMBulletLoadSceneBinary(sceneDescription) {
+	var frames = [sceneDescription.binary];
+	var args = {sceneFrame: 0, narrowphaseThreads: sceneDescription.narrowphaseThreads,
+		broadphaseThreads: sceneDescription.broadphaseThreads, broadphaseMargin: sceneDescription.broadphaseMargin,
+		substeps: sceneDescription.substeps,
+		batchedIntegration: sceneDescription.batchedIntegration,
+		linearSleepingThreshold: sceneDescription.linearSleepingThreshold,
+		angularSleepingThreshold: sceneDescription.angularSleepingThreshold,
+		deactivationTime: sceneDescription.deactivationTime};
+	// The file does not keep collision filters
+	var bodies = sceneDescription.bodies;
+	var filtered = false;
+	for (var i = 0; i < bodies.length; i++) {
+		filtered = filtered || bodies[i].group != undefined || bodies[i].mask != undefined;
+	}
+	if (filtered) {
+		var filters = new Int16Array(bodies.length * 2);
+		for (i = 0; i < bodies.length; i++) {
+			filters[i*2+0] = bodies[i].group || 0;
+			filters[i*2+1] = bodies[i].mask || 0;
+		}
+		args.filtersFrame = frames.length;
+		frames.push(filters.buffer);
+	}
+	aM.sendMessage('loadscenebinary', args, frames);
+}
+
+// Asks the module to convert the loaded scene into a .bullet file.
+function NaClAMBulletSaveSceneBinary() {
+	aM.sendMessage('savescenebinary', {});
+}
+
+function NaClAMBulletSceneBinaryHandler(msg) {
+	if (msg.header.error != undefined) {
+		console.log('No binary scene: ' + msg.header.error);
+		return;
+	}
+	console.log('Binary scene is ' + msg.frames[0].byteLength + ' bytes, converted in ' + msg.header.savetime + ' microseconds');
+	if (lastSceneDescription != undefined) {
+		lastSceneDescription.binary = msg.frames[0];
+	}
+}
+
+function NaClAMBulletBvhBuiltHandler(msg) {
+	// Keep the serialized BVH so reloading the scene does not rebuild it.
+	if (lastSceneDescription == undefined) {
+		return;
+	}
+	var shapes = lastSceneDescription.shapes;
+	for (var i = 0; i < shapes.length; i++) {
+		if (shapes[i].name == msg.header.shape) {
+			shapes[i].bvh = msg.frames[0];
+		}
+	}
 }
 
 function NaClAMBulletSceneLoadedHandler(msg) {
 	console.log('Scene loaded.');
 	console.log('Scene object count = ' + msg.header.sceneobjectcount);
+	console.log('Scene load time = ' + msg.header.loadtime + ' microseconds (' + msg.header.format + ')');
+	if (msg.header.sceneobjectcount != objects.length) {
+		console.log('Scene object count does not match ' + objects.length + ' rendered objects.');
+	}
+}
+
+// Snapshots are kept in numbered slots by the module until the scene is
+// reloaded. Restoring keeps the slot.
+function NaClAMBulletSnapshot(slot) {
+	aM.sendMessage('snapshot', {slot: slot});
+}
+
+function NaClAMBulletRestore(slot) {
+	aM.sendMessage('restore', {slot: slot});
+}
+
+function NaClAMBulletSnapshotHandler(msg) {
+	console.log('Snapshot ' + msg.header.slot + ' is ' + msg.header.snapshotsize + ' bytes, taken in ' + msg.header.snapshottime + ' microseconds');
+}
+
+function NaClAMBulletRestoredHandler(msg) {
+	if (msg.header.error != undefined) {
+		console.log('Could not restore snapshot ' + msg.header.slot + ': ' + msg.header.error);
+		return;
+	}
+	console.log('Snapshot ' + msg.header.slot + ' restored in ' + msg.header.restoretime + ' microseconds');
+}
+
+// Gives every body new sleeping settings. Bodies slower than the linear and
+// angular thresholds for deactivationTime seconds may sleep, a
+// deactivationTime of 0 keeps them awake.
+function NaClAMBulletSetSleeping(linearThreshold, angularThreshold, deactivationTime) {
+	aM.sendMessage('setsleeping', {linearSleepingThreshold: linearThreshold,
+		angularSleepingThreshold: angularThreshold, deactivationTime: deactivationTime});
+}
+
+// Steps until every body sleeps, at most maxSteps times, then puts the rest
+// to sleep.
+function NaClAMBulletSettle(maxSteps) {
+	aM.sendMessage('settle', {maxSteps: maxSteps});
+}
+
+function NaClAMBulletSleepingSetHandler(msg) {
+	console.log('Sleeping thresholds ' + msg.header.linearsleepingthreshold + ' and ' + msg.header.angularsleepingthreshold + ' for ' + msg.header.deactivationtime + ' seconds');
+}
+
+function NaClAMBulletSettledHandler(msg) {
+	console.log('Settled in ' + msg.header.steps + ' steps and ' + msg.header.settletime + ' microseconds, ' + msg.header.forced + ' bodies forced to sleep');
+}
+
+// Streams bodies into the loaded scene. Each body needs mass, friction and
+// transform, a column major 4x4 matrix. The module adds at most perStep
+// bodies per step, sceneupdate reports how many are still pending. group and
+// mask are optional collision filters for all of the bodies.
+function NaClAMBulletAddBodies(shapeName, bodies, perStep, group, mask) {
+	var data = new Float32Array(bodies.length * 18);
+	for (var i = 0; i < bodies.length; i++) {
+		data[i*18+0] = bodies[i].mass;
+		data[i*18+1] = bodies[i].friction;
+		for (var j = 0; j < 16; j++) {
+			data[i*18+2+j] = bodies[i].transform[j];
+		}
+	}
+	var args = {shape: shapeName, bodiesFrame: 0};
+	if (perStep != undefined) {
+		args.perStep = perStep;
+	}
+	if (group != undefined) {
+		args.group = group;
+	}
+	if (mask != undefined) {
+		args.mask = mask;
+	}
+	aM.sendMessage('addbodies', args, [data.buffer]);
+}
+
+function NaClAMBulletRemoveBodies(indices) {
+	aM.sendMessage('removebodies', {indices: indices});
+}
+
+// The module fills each removed index with its last body, do the same with
+// the rendered objects.
+function NaClAMBulletBodiesRemovedHandler(msg) {
+	if (msg.header.world != 0) {
+		return;
+	}
+	if (msg.header.error != undefined) {
+		console.log('Could not remove bodies: ' + msg.header.error);
+		return;
+	}
+	var removed = msg.header.removed;
+	for (var i = 0; i < removed.length; i++) {
+		var index = removed[i];
+		var last = objects.pop();
+		scene.remove(index < objects.length ? objects[index] : last);
+		if (index < objects.length) {
+			objects[index] = last;
+			last.objectTableIndex = index;
+		}
+	}
 }
 
 function NaClAMBulletPickObject(objectTableIndex, cameraPos, hitPos) {
@@ -27,13 +263,31 @@ function NaClAMBulletStepSceneHandler(msg) {
 	var i;
 	var j;
 	var numTransforms = 0;
+	if (msg.header.world != 0) {
+		return;
+	}
 	if (msg.header.cmd == 'sceneupdate') {
 		if (skipSceneUpdates > 0) {
 			skipSceneUpdates--;
 			return;
 		}
 		var simTime = msg.header.simtime;
-		document.getElementById('simulationTime').innerHTML = '<p>Simulation time: ' + simTime + ' microseconds</p>';
+		document.getElementById('simulationTime').innerHTML = '<p>Simulation time: ' + simTime + ' microseconds</p>' +
+			'<p>Narrowphase: ' + msg.header.narrowphasetime + ' microseconds, ' +
+			(msg.header.narrowphasepairs > 0 ? msg.header.narrowphasepairs + ' pairs batched, ' : '') +
+			(msg.header.narrowphasefallbackpairs > 0 ? msg.header.narrowphasefallbackpairs + ' on the main thread, ' : '') +
+			msg.header.rejectedpairs + ' filtered out</p>';
+		document.getElementById('simulationTime').innerHTML += '<p>Awake: ' + msg.header.activebodies + ' bodies in ' + msg.header.activeislands + ' islands, asleep: ' +
+			msg.header.sleepingbodies + ' bodies in ' + msg.header.sleepingislands + ' islands</p>';
+		document.getElementById('simulationTime').innerHTML += '<p>Integration: ' + msg.header.integratetime + ' microseconds</p>';
+		document.getElementById('simulationTime').innerHTML += '<p>Heap: ' + msg.header.allocations + ' allocations (' + msg.header.allocatedbytes + ' bytes), ' +
+			msg.header.frees + ' frees</p>';
+		if (msg.header.ccdsweeps > 0) {
+			document.getElementById('simulationTime').innerHTML += '<p>CCD: ' + msg.header.ccdsweeps + ' sweeps in ' + msg.header.ccdtime + ' microseconds</p>';
+		}
+		if (msg.header.pendingbodies > 0) {
+			document.getElementById('simulationTime').innerHTML += '<p>Adding bodies: ' + msg.header.pendingbodies + ' pending</p>';
+		}
 		TransformBuffer = new Float32Array(msg.frames[0]);
 		numTransforms = TransformBuffer.length/16;
 		for (i = 0; i < numTransforms; i++) {
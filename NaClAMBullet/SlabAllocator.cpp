@@ -0,0 +1,462 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "LinearMath/btAlignedAllocator.h"
+#include "LinearMath/btMinMax.h"
+#include "SlabAllocator.h"
+
+// Small blocks are carved from slabs of kSlabSize bytes aligned to
+// kSlabSize, so the slab header of any block is found by masking its
+// address. Slabs are mapped directly so trimmed slabs go back to the system
+// instead of leaving aligned holes in the malloc heap. Larger allocations
+// come straight from malloc with a LargeHeader in front. The slab map tells
+// the two apart when they are freed.
+static const size_t kSlabSize = 64 * 1024;
+static const int kSlabShift = 16;
+static const size_t kSlabHeaderSize = 64;
+static const uint32_t kSlabMagic = 0x51ab51ab;
+static const uint32_t kLargeMagic = 0x1a59e1a5;
+
+// Sizes step by 16 bytes up to 256, then by a quarter of the power of two
+// below, so rounding up wastes at most a fifth of a block. Blocks start
+// 16 byte aligned, and 64 byte aligned in classes that are multiples of 64.
+static const size_t kMaxSmallSize = 8192;
+static const int kNumClasses = 36;
+static size_t classSizes[kNumClasses];
+static int classBatch[kNumClasses];
+static unsigned char sizeToClass[kMaxSmallSize / 16 + 1];
+
+struct SlabHeader {
+  uint32_t magic;
+  int sizeClass;
+  int numBlocks;
+  // Scratch count of this slab's blocks in the depot, used by
+  // slabAllocatorTrim
+  int depotBlocks;
+  // Next slab to release, used by slabAllocatorTrim
+  SlabHeader* nextRelease;
+};
+
+struct LargeHeader {
+  uint32_t magic;
+  // Requested size
+  size_t size;
+  // Start of the malloc block holding the header and the allocation
+  void* memory;
+};
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+/**
+ * Free blocks owned by one thread, and its counts not yet added to the
+ * global totals.
+ */
+struct ThreadCache {
+  FreeBlock* freeLists[kNumClasses];
+  int freeCounts[kNumClasses];
+  int pendingCalls;
+  int64_t pendingBytes;
+  int pendingAllocations;
+  int pendingFrees;
+};
+
+// Free blocks given back by threads with too many, shared by all threads
+struct Depot {
+  FreeBlock* freeList;
+  int freeCount;
+};
+
+// Two level map from address >> kSlabShift to whether a live slab starts
+// there. Leaves cover 4GB each and are allocated under depotMutex the first
+// time a slab lands in their range, then kept. Readers take no lock: a
+// block being freed keeps its slab, and so its entry, alive.
+static const int kSlabMapLeafBits = 16;
+static const int kSlabMapRootBits = 48 - kSlabShift - kSlabMapLeafBits;
+static unsigned char* volatile slabMap[1 << kSlabMapRootBits];
+
+static pthread_mutex_t depotMutex = PTHREAD_MUTEX_INITIALIZER;
+static Depot depots[kNumClasses];
+static pthread_key_t threadCacheKey;
+static __thread ThreadCache* threadCache = NULL;
+static bool installed = false;
+
+static volatile int64_t liveBytes = 0;
+static volatile int64_t peakBytes = 0;
+static volatile int64_t slabBytes = 0;
+static volatile int64_t largeBytes = 0;
+static volatile int64_t totalAllocations = 0;
+static volatile int64_t totalFrees = 0;
+static volatile int threadCaches = 0;
+
+static SlabHeader* slabOf(void* ptr) {
+  return (SlabHeader*)((uintptr_t)ptr & ~(uintptr_t)(kSlabSize - 1));
+}
+
+static bool isSlab(SlabHeader* slab) {
+  uint64_t index = (uint64_t)(uintptr_t)slab >> kSlabShift;
+  uint64_t root = index >> kSlabMapLeafBits;
+  if (root >= (uint64_t)(1 << kSlabMapRootBits)) {
+    return false;
+  }
+  unsigned char* leaf = slabMap[root];
+  return leaf != NULL && leaf[index & ((1 << kSlabMapLeafBits) - 1)] != 0;
+}
+
+/**
+ * Marks slab live or not in the slab map. The caller holds depotMutex.
+ * Returns false when the address is out of the map's range or a leaf cannot
+ * be allocated.
+ */
+static bool setSlab(SlabHeader* slab, bool live) {
+  uint64_t index = (uint64_t)(uintptr_t)slab >> kSlabShift;
+  uint64_t root = index >> kSlabMapLeafBits;
+  if (root >= (uint64_t)(1 << kSlabMapRootBits)) {
+    return false;
+  }
+  unsigned char* leaf = slabMap[root];
+  if (leaf == NULL) {
+    leaf = (unsigned char*)calloc(1, 1 << kSlabMapLeafBits);
+    if (leaf == NULL) {
+      return false;
+    }
+    // The zeroed leaf must be visible before its pointer
+    __sync_synchronize();
+    slabMap[root] = leaf;
+  }
+  leaf[index & ((1 << kSlabMapLeafBits) - 1)] = live ? 1 : 0;
+  return true;
+}
+
+/**
+ * Maps a kSlabSize aligned slab, or returns NULL when out of memory.
+ */
+static void* mapSlab() {
+  // Map twice the size and unmap the ends around the aligned middle
+  char* memory = (char*)mmap(NULL, 2 * kSlabSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == (char*)MAP_FAILED) {
+    return NULL;
+  }
+  char* slab = (char*)(((uintptr_t)memory + kSlabSize - 1) & ~(uintptr_t)(kSlabSize - 1));
+  if (slab > memory) {
+    munmap(memory, slab - memory);
+  }
+  munmap(slab + kSlabSize, memory + kSlabSize - slab);
+  return slab;
+}
+
+static void addLiveBytes(int64_t bytes) {
+  int64_t live = __sync_add_and_fetch(&liveBytes, bytes);
+  int64_t peak = peakBytes;
+  while (live > peak) {
+    int64_t seen = __sync_val_compare_and_swap(&peakBytes, peak, live);
+    if (seen == peak) {
+      break;
+    }
+    peak = seen;
+  }
+}
+
+static void flushStats(ThreadCache* cache) {
+  if (cache->pendingBytes != 0) {
+    addLiveBytes(cache->pendingBytes);
+  }
+  __sync_add_and_fetch(&totalAllocations, (int64_t)cache->pendingAllocations);
+  __sync_add_and_fetch(&totalFrees, (int64_t)cache->pendingFrees);
+  cache->pendingCalls = 0;
+  cache->pendingBytes = 0;
+  cache->pendingAllocations = 0;
+  cache->pendingFrees = 0;
+}
+
+static void countCall(ThreadCache* cache, int64_t bytes) {
+  cache->pendingBytes += bytes;
+  if (bytes > 0) {
+    cache->pendingAllocations++;
+  } else {
+    cache->pendingFrees++;
+  }
+  if (++cache->pendingCalls >= 64 || cache->pendingBytes >= 65536 ||
+      cache->pendingBytes <= -65536) {
+    flushStats(cache);
+  }
+}
+
+/**
+ * Moves count blocks from the front of list to the depot. The caller holds
+ * depotMutex.
+ */
+static FreeBlock* giveToDepot(int sizeClass, FreeBlock* list, int count) {
+  FreeBlock* last = list;
+  for (int i = 1; i < count; i++) {
+    last = last->next;
+  }
+  FreeBlock* rest = last->next;
+  Depot& depot = depots[sizeClass];
+  last->next = depot.freeList;
+  depot.freeList = list;
+  depot.freeCount += count;
+  return rest;
+}
+
+/**
+ * Moves all of cache's free blocks to the depot. The caller holds
+ * depotMutex.
+ */
+static void emptyThreadCache(ThreadCache* cache) {
+  for (int i = 0; i < kNumClasses; i++) {
+    if (cache->freeCounts[i] > 0) {
+      giveToDepot(i, cache->freeLists[i], cache->freeCounts[i]);
+      cache->freeLists[i] = NULL;
+      cache->freeCounts[i] = 0;
+    }
+  }
+}
+
+static void destroyThreadCache(void* data) {
+  ThreadCache* cache = (ThreadCache*)data;
+  pthread_mutex_lock(&depotMutex);
+  emptyThreadCache(cache);
+  pthread_mutex_unlock(&depotMutex);
+  flushStats(cache);
+  __sync_sub_and_fetch(&threadCaches, 1);
+  threadCache = NULL;
+  free(cache);
+}
+
+static ThreadCache* getThreadCache() {
+  ThreadCache* cache = threadCache;
+  if (cache == NULL) {
+    cache = (ThreadCache*)calloc(1, sizeof(ThreadCache));
+    pthread_setspecific(threadCacheKey, cache);
+    __sync_add_and_fetch(&threadCaches, 1);
+    threadCache = cache;
+  }
+  return cache;
+}
+
+/**
+ * Fills an empty thread free list from the depot, or from a new slab when
+ * the depot has none. Returns false when out of memory.
+ */
+static bool refill(ThreadCache* cache, int sizeClass) {
+  pthread_mutex_lock(&depotMutex);
+  Depot& depot = depots[sizeClass];
+  if (depot.freeCount > 0) {
+    int count = btMin(depot.freeCount, classBatch[sizeClass]);
+    FreeBlock* list = depot.freeList;
+    FreeBlock* last = list;
+    for (int i = 1; i < count; i++) {
+      last = last->next;
+    }
+    depot.freeList = last->next;
+    depot.freeCount -= count;
+    pthread_mutex_unlock(&depotMutex);
+    last->next = NULL;
+    cache->freeLists[sizeClass] = list;
+    cache->freeCounts[sizeClass] = count;
+    return true;
+  }
+  pthread_mutex_unlock(&depotMutex);
+
+  void* memory = mapSlab();
+  if (memory == NULL) {
+    return false;
+  }
+  size_t blockSize = classSizes[sizeClass];
+  int count = int((kSlabSize - kSlabHeaderSize) / blockSize);
+  SlabHeader* slab = (SlabHeader*)memory;
+  slab->magic = kSlabMagic;
+  slab->sizeClass = sizeClass;
+  slab->numBlocks = count;
+  slab->depotBlocks = 0;
+  slab->nextRelease = NULL;
+  pthread_mutex_lock(&depotMutex);
+  bool mapped = setSlab(slab, true);
+  pthread_mutex_unlock(&depotMutex);
+  if (!mapped) {
+    munmap(memory, kSlabSize);
+    return false;
+  }
+  __sync_add_and_fetch(&slabBytes, (int64_t)kSlabSize);
+  char* first = (char*)memory + kSlabHeaderSize;
+  FreeBlock* list = NULL;
+  for (int i = count - 1; i >= 0; i--) {
+    FreeBlock* block = (FreeBlock*)(first + i * blockSize);
+    block->next = list;
+    list = block;
+  }
+  cache->freeLists[sizeClass] = list;
+  cache->freeCounts[sizeClass] = count;
+  return true;
+}
+
+static void* allocateLarge(size_t size, int alignment) {
+  size_t align = btMax((size_t)alignment, sizeof(void*));
+  void* memory = malloc(sizeof(LargeHeader) + align - 1 + size);
+  if (memory == NULL) {
+    return NULL;
+  }
+  uintptr_t start = (uintptr_t)memory + sizeof(LargeHeader);
+  char* ptr = (char*)((start + align - 1) & ~(uintptr_t)(align - 1));
+  LargeHeader* header = (LargeHeader*)ptr - 1;
+  header->magic = kLargeMagic;
+  header->size = size;
+  header->memory = memory;
+  __sync_add_and_fetch(&largeBytes, (int64_t)size);
+  countCall(getThreadCache(), (int64_t)size);
+  return ptr;
+}
+
+static void* slabAlloc(size_t size, int alignment) {
+  if (size == 0) {
+    size = 1;
+  }
+  if (size > kMaxSmallSize || alignment > (int)kSlabHeaderSize) {
+    return allocateLarge(size, alignment);
+  }
+  int sizeClass = sizeToClass[(size + 15) / 16];
+  // Alignments are powers of two, and every class is a multiple of 16
+  while ((classSizes[sizeClass] & (alignment - 1)) != 0) {
+    sizeClass++;
+    if (sizeClass == kNumClasses) {
+      return allocateLarge(size, alignment);
+    }
+  }
+  ThreadCache* cache = getThreadCache();
+  if (cache->freeCounts[sizeClass] == 0 && !refill(cache, sizeClass)) {
+    return NULL;
+  }
+  FreeBlock* block = cache->freeLists[sizeClass];
+  cache->freeLists[sizeClass] = block->next;
+  cache->freeCounts[sizeClass]--;
+  countCall(cache, (int64_t)classSizes[sizeClass]);
+  return block;
+}
+
+static void slabFree(void* ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+  ThreadCache* cache = getThreadCache();
+  SlabHeader* slab = slabOf(ptr);
+  if (!isSlab(slab)) {
+    LargeHeader* header = (LargeHeader*)ptr - 1;
+    btAssert(header->magic == kLargeMagic);
+    __sync_sub_and_fetch(&largeBytes, (int64_t)header->size);
+    countCall(cache, -(int64_t)header->size);
+    header->magic = 0;
+    free(header->memory);
+    return;
+  }
+  btAssert(slab->magic == kSlabMagic);
+  int sizeClass = slab->sizeClass;
+  FreeBlock* block = (FreeBlock*)ptr;
+  block->next = cache->freeLists[sizeClass];
+  cache->freeLists[sizeClass] = block;
+  cache->freeCounts[sizeClass]++;
+  countCall(cache, -(int64_t)classSizes[sizeClass]);
+  // Keep at most two batches, the rest goes back for other threads
+  int batch = classBatch[sizeClass];
+  if (cache->freeCounts[sizeClass] > 2 * batch) {
+    pthread_mutex_lock(&depotMutex);
+    cache->freeLists[sizeClass] = giveToDepot(sizeClass, cache->freeLists[sizeClass], batch);
+    pthread_mutex_unlock(&depotMutex);
+    cache->freeCounts[sizeClass] -= batch;
+  }
+}
+
+void slabAllocatorInstall() {
+  if (installed) {
+    return;
+  }
+  installed = true;
+  int numClasses = 0;
+  for (size_t size = 16; size <= 256; size += 16) {
+    classSizes[numClasses++] = size;
+  }
+  for (size_t base = 256; base < kMaxSmallSize; base *= 2) {
+    for (size_t step = 1; step <= 4; step++) {
+      classSizes[numClasses++] = base + step * base / 4;
+    }
+  }
+  btAssert(numClasses == kNumClasses);
+  int sizeClass = 0;
+  for (size_t i = 0; i <= kMaxSmallSize / 16; i++) {
+    while (classSizes[sizeClass] < i * 16) {
+      sizeClass++;
+    }
+    sizeToClass[i] = (unsigned char)sizeClass;
+  }
+  // Threads move blocks to and from the depot about 16KB at a time
+  for (int i = 0; i < kNumClasses; i++) {
+    classBatch[i] = btMax(8, btMin(128, int(16384 / classSizes[i])));
+  }
+  pthread_key_create(&threadCacheKey, destroyThreadCache);
+  btAlignedAllocSetCustomAligned(slabAlloc, slabFree);
+}
+
+int64_t slabAllocatorTrim() {
+  if (!installed) {
+    return 0;
+  }
+  pthread_mutex_lock(&depotMutex);
+  if (threadCache != NULL) {
+    emptyThreadCache(threadCache);
+  }
+  SlabHeader* release = NULL;
+  int64_t released = 0;
+  for (int i = 0; i < kNumClasses; i++) {
+    Depot& depot = depots[i];
+    for (FreeBlock* block = depot.freeList; block != NULL; block = block->next) {
+      slabOf(block)->depotBlocks++;
+    }
+    // Unlink the blocks of slabs that are entirely in the depot. A slab is
+    // queued for release at its first block so it is only queued once
+    FreeBlock** link = &depot.freeList;
+    while (*link != NULL) {
+      FreeBlock* block = *link;
+      SlabHeader* slab = slabOf(block);
+      if (slab->depotBlocks == slab->numBlocks) {
+        *link = block->next;
+        depot.freeCount--;
+        if ((char*)block == (char*)slab + kSlabHeaderSize) {
+          slab->nextRelease = release;
+          release = slab;
+        }
+      } else {
+        link = &block->next;
+      }
+    }
+    for (FreeBlock* block = depot.freeList; block != NULL; block = block->next) {
+      slabOf(block)->depotBlocks = 0;
+    }
+  }
+  while (release != NULL) {
+    SlabHeader* slab = release;
+    release = slab->nextRelease;
+    setSlab(slab, false);
+    munmap(slab, kSlabSize);
+    released += kSlabSize;
+  }
+  pthread_mutex_unlock(&depotMutex);
+  __sync_sub_and_fetch(&slabBytes, released);
+  return released;
+}
+
+void slabAllocatorGetStats(SlabAllocatorStats* stats) {
+  // Count this thread's pending calls so a query right after a step is exact
+  // for the stepping thread
+  if (threadCache != NULL) {
+    flushStats(threadCache);
+  }
+  stats->liveBytes = __sync_add_and_fetch(&liveBytes, 0);
+  stats->peakBytes = __sync_add_and_fetch(&peakBytes, 0);
+  stats->slabBytes = __sync_add_and_fetch(&slabBytes, 0);
+  stats->largeBytes = __sync_add_and_fetch(&largeBytes, 0);
+  stats->allocations = (uint64_t)__sync_add_and_fetch(&totalAllocations, 0);
+  stats->frees = (uint64_t)__sync_add_and_fetch(&totalFrees, 0);
+  stats->threadCaches = __sync_add_and_fetch(&threadCaches, 0);
+}
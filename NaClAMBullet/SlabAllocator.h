@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Totals kept by the slab allocator. Threads add their counts in batches,
+ * so liveBytes, allocations and frees can lag each thread by up to 64KB or
+ * 64 calls.
+ */
+struct SlabAllocatorStats {
+  // Bytes in blocks handed out and not yet freed, rounded up to their size
+  // class, plus large allocations
+  int64_t liveBytes;
+  // Highest liveBytes seen since slabAllocatorInstall
+  int64_t peakBytes;
+  // Bytes in slabs, used or not. Slabs are kept for reuse until
+  // slabAllocatorTrim finds them entirely free
+  int64_t slabBytes;
+  // Bytes in allocations too large for a size class, each one its own
+  // malloc block
+  int64_t largeBytes;
+  uint64_t allocations;
+  uint64_t frees;
+  // Threads that have allocated and not exited
+  int threadCaches;
+};
+
+/**
+ * Routes btAlignedAlloc and btAlignedFree to a size classed slab allocator
+ * with a free list cache per thread. Must run before Bullet allocates
+ * anything, memory from the previous allocator cannot be freed here.
+ * Calling it again does nothing.
+ */
+void slabAllocatorInstall();
+
+/**
+ * Returns slabs whose blocks are all free to the system. The calling
+ * thread's cached blocks are given up first; blocks cached by other threads
+ * keep their slabs. Returns the number of bytes released.
+ */
+int64_t slabAllocatorTrim();
+
+/**
+ * Fills stats with the current totals of all threads.
+ */
+void slabAllocatorGetStats(SlabAllocatorStats* stats);
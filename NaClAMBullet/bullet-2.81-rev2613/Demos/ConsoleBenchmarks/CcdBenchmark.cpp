@@ -0,0 +1,107 @@
+// CcdBenchmark compares continuous collision detection on only the fast bodies with
+// substepping the whole world, the two ways a scene can stop small fast bodies from
+// tunneling. 100 cubes of 0.2 m fall from y=550 onto a 0.1 m plate at y=50, hitting it
+// at about 99 m/s (1.65 m per 1/60 s step), next to 1000 resting 1 m cubes that never
+// need CCD. The world is stepped like the module's stepscene.
+
+#include <stdio.h>
+
+#include "btBulletDynamicsCommon.h"
+#include "LinearMath/btQuickprof.h"
+
+#define NUM_FAST_BODIES 100
+#define NUM_RESTING_BODIES 1000
+#define NUM_STEPS 720
+
+struct CcdRun
+{
+	int				m_fellThrough;
+	double			m_stepTime;
+};
+
+static CcdRun	run(bool ccd,int substeps)
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btDbvtBroadphase broadphase;
+	btSequentialImpulseConstraintSolver solver;
+	btDiscreteDynamicsWorld world(&dispatcher,&broadphase,&solver,&collisionConfiguration);
+
+	btBoxShape plateShape(btVector3(20,0.05,20));
+	btBoxShape fastShape(btVector3(0.1,0.1,0.1));
+	btBoxShape restingShape(btVector3(0.5,0.5,0.5));
+	btBoxShape groundShape(btVector3(100,0.5,100));
+
+	btAlignedObjectArray<btRigidBody*> bodies;
+	btAlignedObjectArray<btDefaultMotionState*> motionStates;
+	btVector3 inertia;
+	fastShape.calculateLocalInertia(1,inertia);
+
+	btTransform transform;
+	transform.setIdentity();
+	transform.setOrigin(btVector3(0,50,0));
+	motionStates.push_back(new btDefaultMotionState(transform));
+	bodies.push_back(new btRigidBody(0,motionStates[0],&plateShape));
+	transform.setOrigin(btVector3(0,-0.5,0));
+	motionStates.push_back(new btDefaultMotionState(transform));
+	bodies.push_back(new btRigidBody(0,motionStates[1],&groundShape));
+
+	for (int i=0;i<NUM_FAST_BODIES;i++)
+	{
+		transform.setOrigin(btVector3((i%10)*2-10,550+(i/100)*0.5,((i/10)%10)*2-10));
+		btDefaultMotionState* motionState = new btDefaultMotionState(transform);
+		btRigidBody* body = new btRigidBody(1,motionState,&fastShape,inertia);
+		if (ccd)
+		{
+			body->setCcdMotionThreshold(0.05);
+			body->setCcdSweptSphereRadius(0.08);
+		}
+		motionStates.push_back(motionState);
+		bodies.push_back(body);
+	}
+	restingShape.calculateLocalInertia(1,inertia);
+	for (int i=0;i<NUM_RESTING_BODIES;i++)
+	{
+		transform.setOrigin(btVector3((i%20)-10+30,0.5+(i/400)*1.1,((i/20)%20)-10));
+		btDefaultMotionState* motionState = new btDefaultMotionState(transform);
+		motionStates.push_back(motionState);
+		bodies.push_back(new btRigidBody(1,motionState,&restingShape,inertia));
+	}
+	for (int i=0;i<bodies.size();i++)
+		world.addRigidBody(bodies[i]);
+
+	btClock clock;
+	for (int i=0;i<NUM_STEPS;i++)
+		world.stepSimulation(1.0/60.0,substeps,1.0/(60.0*substeps));
+	CcdRun result;
+	result.m_stepTime = double(clock.getTimeMicroseconds())/NUM_STEPS;
+
+	result.m_fellThrough = 0;
+	for (int i=0;i<NUM_FAST_BODIES;i++)
+	{
+		if (bodies[i+2]->getWorldTransform().getOrigin().getY() < 49)
+			result.m_fellThrough++;
+	}
+
+	for (int i=0;i<bodies.size();i++)
+	{
+		world.removeRigidBody(bodies[i]);
+		delete bodies[i];
+		delete motionStates[i];
+	}
+	return result;
+}
+
+static void	report(const char* name,const CcdRun& result)
+{
+	printf("%-24s %3d/%d fell through the plate, %8.1f us/step\n",
+		name,result.m_fellThrough,NUM_FAST_BODIES,result.m_stepTime);
+}
+
+int main()
+{
+	report("no CCD",run(false,1));
+	report("CCD on fast bodies",run(true,1));
+	report("4 substeps",run(false,4));
+	return 0;
+}
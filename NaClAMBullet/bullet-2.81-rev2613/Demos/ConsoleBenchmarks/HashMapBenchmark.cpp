@@ -0,0 +1,142 @@
+// HashMapBenchmark compares btHashMap with btFlatHashMap on pointer keys, the keys of the
+// serializer's maps, for insertion with and without reserve and for single and batched
+// lookups in a shuffled order. It then times btDefaultSerializer on worlds of 1000 to
+// 50000 boxes and spheres, which is dominated by those pointer lookups.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "btBulletDynamicsCommon.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btMinMax.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btSerializer.h"
+
+#define NUM_REPEATS 5
+
+static void	benchmarkMaps(int count)
+{
+	btAlignedObjectArray<char*> blocks;
+	for (int i=0;i<count;i++)
+		blocks.push_back((char*)malloc(48));
+	// Look the keys up in a different order than they were inserted in
+	btAlignedObjectArray<btHashPtr> keys;
+	for (int i=0;i<count;i++)
+		keys.push_back(btHashPtr(blocks[(int)((long long)i*7919%count)]));
+	btAlignedObjectArray<int*> values;
+	values.resize(count);
+
+	enum {INSERT_CHAINED,INSERT_FLAT,INSERT_RESERVED,FIND_CHAINED,FIND_FLAT,FIND_MANY,NUM_TIMINGS};
+	unsigned long int best[NUM_TIMINGS];
+	for (int k=0;k<NUM_TIMINGS;k++)
+		best[k] = 0xffffffff;
+	long checksum = 0;
+	btClock clock;
+	for (int r=0;r<NUM_REPEATS;r++)
+	{
+		btHashMap<btHashPtr,int> chained;
+		btFlatHashMap<btHashPtr,int> flat;
+		btFlatHashMap<btHashPtr,int> reserved;
+		unsigned long int times[NUM_TIMINGS];
+
+		clock.reset();
+		for (int i=0;i<count;i++)
+			chained.insert(blocks[i],i);
+		times[INSERT_CHAINED] = clock.getTimeMicroseconds();
+		clock.reset();
+		for (int i=0;i<count;i++)
+			flat.insert(blocks[i],i);
+		times[INSERT_FLAT] = clock.getTimeMicroseconds();
+		clock.reset();
+		reserved.reserve(count);
+		for (int i=0;i<count;i++)
+			reserved.insert(blocks[i],i);
+		times[INSERT_RESERVED] = clock.getTimeMicroseconds();
+
+		clock.reset();
+		for (int i=0;i<count;i++)
+			checksum += *chained.find(keys[i]);
+		times[FIND_CHAINED] = clock.getTimeMicroseconds();
+		clock.reset();
+		for (int i=0;i<count;i++)
+			checksum += *flat.find(keys[i]);
+		times[FIND_FLAT] = clock.getTimeMicroseconds();
+		clock.reset();
+		flat.findMany(&keys[0],count,&values[0]);
+		for (int i=0;i<count;i++)
+			checksum += *values[i];
+		times[FIND_MANY] = clock.getTimeMicroseconds();
+
+		for (int k=0;k<NUM_TIMINGS;k++)
+			best[k] = btMin(best[k],times[k]);
+	}
+
+	double scale = 1000.0/count;
+	printf("%8d keys, ns/key: insert chained %5.1f flat %5.1f reserved %5.1f, find chained %5.1f flat %5.1f findMany %5.1f%s\n",
+		count,best[INSERT_CHAINED]*scale,best[INSERT_FLAT]*scale,best[INSERT_RESERVED]*scale,
+		best[FIND_CHAINED]*scale,best[FIND_FLAT]*scale,best[FIND_MANY]*scale,
+		checksum < 0 ? "!" : "");
+	for (int i=0;i<count;i++)
+		free(blocks[i]);
+}
+
+static void	benchmarkSerializer(int numBodies)
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btDbvtBroadphase broadphase;
+	btSequentialImpulseConstraintSolver solver;
+	btDiscreteDynamicsWorld world(&dispatcher,&broadphase,&solver,&collisionConfiguration);
+
+	// Every body has its own shape, as in a loaded scene, so each is its own chunk
+	btAlignedObjectArray<btCollisionShape*> shapes;
+	btAlignedObjectArray<btRigidBody*> bodies;
+	for (int i=0;i<numBodies;i++)
+	{
+		btTransform transform;
+		transform.setIdentity();
+		transform.setOrigin(btVector3((i%50)*2.f,(i/2500)*2.f,((i/50)%50)*2.f));
+		btCollisionShape* shape;
+		if (i%3==0)
+			shape = new btSphereShape(0.5f+i%7*0.01f);
+		else
+			shape = new btBoxShape(btVector3(0.5f,0.5f+i%5*0.01f,0.5f));
+		btRigidBody* body = new btRigidBody(1,0,shape,btVector3(1,1,1));
+		body->setWorldTransform(transform);
+		world.addRigidBody(body);
+		shapes.push_back(shape);
+		bodies.push_back(body);
+	}
+
+	unsigned long int best = 0xffffffff;
+	int size = 0;
+	btClock clock;
+	for (int r=0;r<NUM_REPEATS;r++)
+	{
+		clock.reset();
+		btDefaultSerializer* serializer = new btDefaultSerializer();
+		world.serialize(serializer);
+		best = btMin(best,clock.getTimeMicroseconds());
+		size = serializer->getCurrentBufferSize();
+		delete serializer;
+	}
+	printf("%8d bodies: serialize %8.2f ms, %d bytes\n",numBodies,best/1000.0,size);
+
+	for (int i=0;i<bodies.size();i++)
+	{
+		world.removeRigidBody(bodies[i]);
+		delete bodies[i];
+		delete shapes[i];
+	}
+}
+
+int main()
+{
+	benchmarkMaps(10000);
+	benchmarkMaps(100000);
+	benchmarkMaps(1000000);
+	benchmarkSerializer(1000);
+	benchmarkSerializer(10000);
+	benchmarkSerializer(50000);
+	return 0;
+}
@@ -0,0 +1,92 @@
+// JsonReaderBenchmark compares jsoncpp's Json::Reader with NaClAMParseJsonInPlace
+// on a stepscene header, parsed into a per message NodeArena as the module does,
+// and on a 10 MB loadscene description. Both trees are checked to be equal.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "json/json.h"
+#include "NaClAMJsonReader.h"
+#include "LinearMath/btMinMax.h"
+#include "LinearMath/btQuickprof.h"
+
+static const char*	sHeader = "{\"cmd\":\"stepscene\",\"request\":1234,\"frames\":0,"
+	"\"args\":{\"rayFrom\":[0.5,20.25,40],\"rayTo\":[-3.75,1.5e1,-12.125]}}";
+
+static std::string	makeScene(size_t size)
+{
+	std::string scene = "{\"narrowphaseThreads\":0,\"shapes\":[{\"name\":\"box\",\"type\":\"cube\",\"wx\":1,\"wy\":1,\"wz\":1},"
+		"{\"name\":\"hull\",\"type\":\"convex\",\"points\":[";
+	char tmp[256];
+	for (int i=0;i<2000;i++)
+	{
+		snprintf(tmp,sizeof(tmp),"%s[%.6f,%.6f,%.6f]",i?",":"",i*0.001,-i*0.002,i*0.0031);
+		scene += tmp;
+	}
+	scene += "]}],\"bodies\":[";
+	for (int i=0;scene.size()<size;i++)
+	{
+		snprintf(tmp,sizeof(tmp),"%s{\"shape\":\"box\",\"mass\":1,\"friction\":0.8,\"transform\":[1,0,0,0,0,1,0,0,0,0,1,0,%.4f,%.4f,%.4f,1]}",
+			i?",":"",i*0.5,i*0.25,-i*0.125);
+		scene += tmp;
+	}
+	scene += "]}";
+	return scene;
+}
+
+///parses text iterations times with each reader and prints microseconds per parse
+static bool	benchmark(const char* name,const std::string& text,int iterations)
+{
+	btClock clock;
+	for (int i=0;i<iterations;i++)
+	{
+		Json::Reader reader;
+		Json::Value root;
+		reader.parse(text.data(),text.data()+text.size(),root);
+	}
+	unsigned long int readerTime = clock.getTimeMicroseconds();
+
+	// The module parses into a copy of the message text and one arena per message
+	std::vector<char> buffer;
+	Json::NodeArena arena;
+	clock.reset();
+	for (int i=0;i<iterations;i++)
+	{
+		buffer.assign(text.begin(),text.end());
+		buffer.push_back(0);
+		{
+			Json::NodeArena::Scope scope(arena);
+			Json::Value root;
+			NaClAMParseJsonInPlace(&buffer[0],(uint32_t)text.size(),root);
+		}
+		arena.release();
+	}
+	unsigned long int inPlaceTime = clock.getTimeMicroseconds();
+
+	Json::Reader reader;
+	Json::Value expected;
+	reader.parse(text.data(),text.data()+text.size(),expected);
+	buffer.assign(text.begin(),text.end());
+	buffer.push_back(0);
+	Json::Value parsed;
+	bool ok;
+	{
+		Json::NodeArena::Scope scope(arena);
+		ok = NaClAMParseJsonInPlace(&buffer[0],(uint32_t)text.size(),parsed) && parsed == expected;
+	}
+
+	printf("%-8s %9d bytes: Json::Reader %10.1f us, in place %10.1f us (%.2fx)%s\n",
+		name,(int)text.size(),
+		double(readerTime)/iterations,double(inPlaceTime)/iterations,
+		double(readerTime)/double(btMax(inPlaceTime,1UL)),
+		ok ? "" : ", TREES DIFFER");
+	return ok;
+}
+
+int main()
+{
+	bool ok = benchmark("header",sHeader,200000);
+	ok = benchmark("scene",makeScene(10*1000*1000),5) && ok;
+	return ok ? 0 : 1;
+}
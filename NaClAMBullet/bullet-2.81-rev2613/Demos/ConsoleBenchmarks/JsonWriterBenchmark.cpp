@@ -0,0 +1,156 @@
+// JsonWriterBenchmark compares the Json::StyledWriter reply headers the module used
+// to send with the compact NaClAMWriteJson headers NaClAMSendMessage writes now, on
+// a sceneupdate reply, a 20 node profile reply, bursts of NaClAMPrintf lines and 1 KB prints.
+// Both texts are checked to parse to the same tree.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "json/json.h"
+#include "NaClAMJsonWriter.h"
+#include "LinearMath/btQuickprof.h"
+
+static std::string	sHeaderText;
+static size_t		sWritten;
+
+///the old NaClAMSendMessage: copy the header, add frames and write it styled
+static void	writeStyled(const Json::Value& header,unsigned int numFrames)
+{
+	Json::StyledWriter writer;
+	Json::Value root = header;
+	root["frames"] = Json::Value(numFrames);
+	sHeaderText = writer.write(root);
+	sWritten += sHeaderText.size();
+}
+
+///the current NaClAMSendMessage: frames first, then the header members compactly
+static void	writeCompact(const Json::Value& header,unsigned int numFrames)
+{
+	sHeaderText.clear();
+	sHeaderText += "{\"frames\":";
+	NaClAMWriteJsonInt(sHeaderText,numFrames);
+	for (Json::Value::const_iterator it = header.begin(); it != header.end(); ++it)
+	{
+		if (strcmp(it.memberName(),"frames")==0)
+			continue;
+		sHeaderText += ',';
+		NaClAMWriteJsonString(sHeaderText,it.memberName());
+		sHeaderText += ':';
+		NaClAMWriteJson(sHeaderText,*it);
+	}
+	sHeaderText += '}';
+	sWritten += sHeaderText.size();
+}
+
+static Json::Value	printHeader(const char* line)
+{
+	Json::Value header;
+	header["cmd"] = Json::Value("NaClAMPrint");
+	header["request"] = Json::Value(-1);
+	header["print"] = Json::Value(line);
+	return header;
+}
+
+static bool	sameTree(const std::string& a,const std::string& b)
+{
+	Json::Reader reader;
+	Json::Value x,y;
+	return reader.parse(a,x) && reader.parse(b,y) && x==y;
+}
+
+static bool	report(const char* name,unsigned long int styledTime,unsigned long int compactTime,int iterations,const Json::Value& header)
+{
+	writeStyled(header,2);
+	std::string styled = sHeaderText;
+	writeCompact(header,2);
+	bool ok = sameTree(styled,sHeaderText);
+	printf("%-12s StyledWriter %8.2f us %5d bytes, compact %8.2f us %5d bytes (%.1fx)%s\n",
+		name,double(styledTime)/iterations,(int)styled.size(),
+		double(compactTime)/iterations,(int)sHeaderText.size(),
+		double(styledTime)/double(compactTime ? compactTime : 1),
+		ok ? "" : ", TREES DIFFER");
+	return ok;
+}
+
+///writes header iterations times both ways
+static bool	benchmark(const char* name,const Json::Value& header,int iterations)
+{
+	btClock clock;
+	for (int i=0;i<iterations;i++)
+		writeStyled(header,2);
+	unsigned long int styledTime = clock.getTimeMicroseconds();
+	clock.reset();
+	for (int i=0;i<iterations;i++)
+		writeCompact(header,2);
+	unsigned long int compactTime = clock.getTimeMicroseconds();
+	return report(name,styledTime,compactTime,iterations,header);
+}
+
+///formats and writes a distinct print line per iteration, as a log burst does
+static bool	benchmarkPrints(int iterations)
+{
+	char line[256];
+	btClock clock;
+	for (int i=0;i<iterations;i++)
+	{
+		snprintf(line,sizeof(line),"Added %d bodies to island %d in %.3f ms",i,i&63,i*0.001);
+		writeStyled(printHeader(line),0);
+	}
+	unsigned long int styledTime = clock.getTimeMicroseconds();
+	clock.reset();
+	for (int i=0;i<iterations;i++)
+	{
+		snprintf(line,sizeof(line),"Added %d bodies to island %d in %.3f ms",i,i&63,i*0.001);
+		writeCompact(printHeader(line),0);
+	}
+	unsigned long int compactTime = clock.getTimeMicroseconds();
+	return report("print burst",styledTime,compactTime,iterations,printHeader(line));
+}
+
+///writes one 1 KB print with characters that need escaping iterations times
+static bool	benchmarkLongPrints(int iterations)
+{
+	char line[1001];
+	memset(line,'x',1000);
+	line[1000] = 0;
+	line[10] = '"';
+	line[500] = '\t';
+	Json::Value header = printHeader(line);
+	return benchmark("1 KB prints",header,iterations);
+}
+
+int main()
+{
+	Json::Value update;
+	update["cmd"] = Json::Value("sceneupdate");
+	update["request"] = Json::Value(-1);
+	update["simtime"] = Json::Value((Json::UInt)1234);
+	update["addedbodies"] = Json::Value(0);
+	update["pendingbodies"] = Json::Value(0);
+
+	Json::Value profile;
+	profile["cmd"] = Json::Value("profile");
+	profile["request"] = Json::Value(7);
+	for (int i=0;i<20;i++)
+	{
+		Json::Value node;
+		node["name"] = Json::Value("solveConstraints");
+		node["time"] = Json::Value(0.25*i);
+		node["calls"] = Json::Value(i);
+		profile["profile"]["children"][i] = node;
+	}
+	// Escapes, large and sparse values must survive the compact writer too
+	profile["escaped"] = Json::Value("a\"b\\c\n\x01");
+	profile["real"] = Json::Value(1e21);
+	profile["big"] = Json::Value(Json::UInt64(18446744073709551615ULL));
+	profile["sparse"][3] = Json::Value(true);
+
+	bool ok = benchmark("sceneupdate",update,500000);
+	ok = benchmark("profile",profile,20000) && ok;
+	ok = benchmarkPrints(200000) && ok;
+	ok = benchmarkLongPrints(100000) && ok;
+	if (sWritten==0)
+		return 1;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+// MaxDotBenchmark times btVector3::maxDot over 8 to 4096 vertices for the scalar loop,
+// each x86 kernel and the runtime dispatched entry point, after checking on random
+// arrays that every kernel returns the same index and dot as the scalar loop.
+// btVector3.cpp is compiled into this file because the per instruction set kernels
+// are static, so LinearMath's own copy of it is never pulled in.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "LinearMath/btVector3.cpp"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+typedef long (*DotKernel)(const float* vv,const float* vec,unsigned long count,float* dotResult);
+
+static long	scalarMaxDot(const float* vv,const float* vec,unsigned long count,float* dotResult)
+{
+	float best = -BT_LARGE_FLOAT;
+	long bestIndex = -1;
+	for (unsigned long i=0;i<count;i++)
+	{
+		float dot = vv[i*4]*vec[0]+vv[i*4+1]*vec[1]+vv[i*4+2]*vec[2];
+		if (dot > best)
+		{
+			best = dot;
+			bestIndex = i;
+		}
+	}
+	*dotResult = best;
+	return bestIndex;
+}
+
+static long	scalarMinDot(const float* vv,const float* vec,unsigned long count,float* dotResult)
+{
+	float negated[4] = {-vec[0],-vec[1],-vec[2],0};
+	long index = scalarMaxDot(vv,negated,count,dotResult);
+	*dotResult = -*dotResult;
+	return index;
+}
+
+static long	dispatchedMaxDot(const float* vv,const float* vec,unsigned long count,float* dotResult)
+{
+	btVector3 v(vec[0],vec[1],vec[2]);
+	return v.maxDot((const btVector3*)vv,count,*dotResult);
+}
+
+static long	dispatchedMinDot(const float* vv,const float* vec,unsigned long count,float* dotResult)
+{
+	btVector3 v(vec[0],vec[1],vec[2]);
+	return v.minDot((const btVector3*)vv,count,*dotResult);
+}
+
+struct KernelPair
+{
+	const char*	m_name;
+	DotKernel	m_maxDot;
+	DotKernel	m_minDot;
+};
+
+static btAlignedObjectArray<KernelPair>	sKernels;
+
+static void	addKernels()
+{
+	KernelPair scalar = {"scalar",scalarMaxDot,scalarMinDot};
+	sKernels.push_back(scalar);
+#if defined (BT_USE_SSE) && !defined (__APPLE__)
+	KernelPair sse = {"sse",_maxdot_large_sse,_mindot_large_sse};
+	sKernels.push_back(sse);
+#ifdef BT_USE_SIMD_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx"))
+	{
+		KernelPair avx = {"avx",_maxdot_large_avx,_mindot_large_avx};
+		sKernels.push_back(avx);
+	}
+#endif //BT_USE_SIMD_DISPATCH
+#endif //BT_USE_SSE
+	KernelPair dispatched = {"maxDot",dispatchedMaxDot,dispatchedMinDot};
+	sKernels.push_back(dispatched);
+}
+
+///compares every kernel with the scalar loop on random arrays and directions
+static int	countMismatches(int trials)
+{
+	int mismatches = 0;
+	btAlignedObjectArray<btVector3> vertices;
+	for (int t=0;t<trials;t++)
+	{
+		int count = 1+rand()%300;
+		vertices.resize(count);
+		float scale = (t%3==0) ? 10.f : 997.f;
+		for (int i=0;i<count;i++)
+			vertices[i].setValue((rand()%2000-1000)/scale,(rand()%2000-1000)/scale,(rand()%2000-1000)/scale);
+		float vec[4] = {(rand()%200-100)/37.f,(rand()%200-100)/41.f,(rand()%200-100)/43.f,0};
+		const float* vv = vertices[0].m_floats;
+
+		float expectedMax,expectedMin;
+		long maxIndex = scalarMaxDot(vv,vec,count,&expectedMax);
+		long minIndex = scalarMinDot(vv,vec,count,&expectedMin);
+		for (int k=1;k<sKernels.size();k++)
+		{
+			float dotMax,dotMin;
+			if (sKernels[k].m_maxDot(vv,vec,count,&dotMax)!=maxIndex || dotMax!=expectedMax ||
+				sKernels[k].m_minDot(vv,vec,count,&dotMin)!=minIndex || dotMin!=expectedMin)
+			{
+				mismatches++;
+			}
+		}
+	}
+	return mismatches;
+}
+
+int main()
+{
+	addKernels();
+	int mismatches = countMismatches(20000);
+	printf("%d mismatches against the scalar loop\n",mismatches);
+
+	printf("%6s","count");
+	for (int k=0;k<sKernels.size();k++)
+		printf(" %10s",sKernels[k].m_name);
+	printf("   (ns per call)\n");
+
+	btAlignedObjectArray<btVector3> vertices;
+	for (int count=8;count<=4096;count*=2)
+	{
+		vertices.resize(count);
+		for (int i=0;i<count;i++)
+			vertices[i].setValue(rand()/btScalar(RAND_MAX)-0.5f,rand()/btScalar(RAND_MAX)-0.5f,rand()/btScalar(RAND_MAX)-0.5f);
+		printf("%6d",count);
+		for (int k=0;k<sKernels.size();k++)
+		{
+			int iterations = 20000000/count;
+			float vec[4] = {0.3f,0.5f,-0.2f,0};
+			float dot;
+			long checksum = 0;
+			btClock clock;
+			for (int i=0;i<iterations;i++)
+			{
+				// Nudge the direction so calls cannot be folded together
+				vec[0] += 1e-7f;
+				checksum += sKernels[k].m_maxDot(vertices[0].m_floats,vec,count,&dot);
+			}
+			unsigned long int time = clock.getTimeMicroseconds();
+			printf(" %10.1f",double(time)*1000.0/iterations);
+			if (checksum < 0)
+				printf("!");
+		}
+		printf("\n");
+	}
+	return mismatches ? 1 : 0;
+}
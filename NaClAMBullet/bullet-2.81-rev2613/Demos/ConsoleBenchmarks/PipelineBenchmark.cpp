@@ -0,0 +1,82 @@
+// PipelineBenchmark times the whole discrete dynamics pipeline on a pile of 2000 boxes
+// and a pile of 1000 random 32 point convex hulls, with deactivation disabled so every
+// step does full work. The vector math mode is fixed when Bullet is built: configure
+// with -DBT_DISABLE_SSE in CMAKE_CXX_FLAGS for the scalar run and compare the tables.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "btBulletDynamicsCommon.h"
+#include "LinearMath/btQuickprof.h"
+
+#define NUM_STEPS 600
+
+static void	run(const char* name,btCollisionShape* shape,int numBodies)
+{
+	btDefaultCollisionConfiguration collisionConfiguration;
+	btCollisionDispatcher dispatcher(&collisionConfiguration);
+	btDbvtBroadphase broadphase;
+	btSequentialImpulseConstraintSolver solver;
+	btDiscreteDynamicsWorld world(&dispatcher,&broadphase,&solver,&collisionConfiguration);
+
+	btStaticPlaneShape groundShape(btVector3(0,1,0),0);
+	btTransform transform;
+	transform.setIdentity();
+	btDefaultMotionState groundMotionState(transform);
+	btRigidBody ground(0,&groundMotionState,&groundShape);
+	world.addRigidBody(&ground);
+
+	btVector3 inertia;
+	shape->calculateLocalInertia(1,inertia);
+	btAlignedObjectArray<btRigidBody*> bodies;
+	for (int i=0;i<numBodies;i++)
+	{
+		transform.setOrigin(btVector3((i%20)*1.5f-15,1+(i/400)*1.5f,((i/20)%20)*1.5f-15));
+		transform.setRotation(btQuaternion(i*0.3f,i*0.7f,0));
+		btRigidBody* body = new btRigidBody(1,new btDefaultMotionState(transform),shape,inertia);
+		body->setActivationState(DISABLE_DEACTIVATION);
+		world.addRigidBody(body);
+		bodies.push_back(body);
+	}
+
+	btClock clock;
+	for (int i=0;i<NUM_STEPS;i++)
+		world.stepSimulation(1.0f/60.0f,0);
+	double stepTime = double(clock.getTimeMicroseconds())/NUM_STEPS;
+
+	// The resting height shows both modes simulated the same pile
+	btScalar height = 0;
+	for (int i=0;i<bodies.size();i++)
+	{
+		height += bodies[i]->getWorldTransform().getOrigin().getY();
+		world.removeRigidBody(bodies[i]);
+		delete bodies[i]->getMotionState();
+		delete bodies[i];
+	}
+	world.removeRigidBody(&ground);
+	printf("%-6s %5d bodies: %9.1f us/step, mean height %.3f\n",name,numBodies,stepTime,height/numBodies);
+}
+
+int main()
+{
+#ifdef BT_USE_SSE
+	printf("vector math: SSE\n");
+#else
+	printf("vector math: scalar\n");
+#endif
+
+	btBoxShape box(btVector3(0.5,0.5,0.5));
+	run("boxes",&box,2000);
+
+	btConvexHullShape hull;
+	srand(1);
+	for (int i=0;i<32;i++)
+	{
+		hull.addPoint(btVector3(rand()/btScalar(RAND_MAX)-0.5f,
+			rand()/btScalar(RAND_MAX)-0.5f,
+			rand()/btScalar(RAND_MAX)-0.5f));
+	}
+	hull.optimizeSupportQueries();
+	run("hulls",&hull,1000);
+	return 0;
+}
@@ -0,0 +1,106 @@
+project "AppCcdBenchmark"
+
+kind "ConsoleApp"
+
+includedirs {"../../src"}
+
+links {
+	"BulletDynamics","BulletCollision", "LinearMath"
+}
+
+language "C++"
+
+files {
+	"CcdBenchmark.cpp",
+}
+
+project "AppPipelineBenchmark"
+
+kind "ConsoleApp"
+
+includedirs {"../../src"}
+
+links {
+	"BulletDynamics","BulletCollision", "LinearMath"
+}
+
+language "C++"
+
+files {
+	"PipelineBenchmark.cpp",
+}
+
+project "AppMaxDotBenchmark"
+
+kind "ConsoleApp"
+
+includedirs {"../../src"}
+
+links {
+	"LinearMath"
+}
+
+language "C++"
+
+files {
+	"MaxDotBenchmark.cpp",
+}
+
+project "AppHashMapBenchmark"
+
+kind "ConsoleApp"
+
+includedirs {"../../src"}
+
+links {
+	"BulletDynamics","BulletCollision", "LinearMath"
+}
+
+language "C++"
+
+files {
+	"HashMapBenchmark.cpp",
+}
+
+-- The JSON benchmarks time the NaCl module's message code, only found when Bullet is built from the module tree
+local naclambase = "../../../../NaClAMBase"
+
+if os.isfile(naclambase .. "/NaClAMJsonReader.cpp") then
+
+project "AppJsonReaderBenchmark"
+
+kind "ConsoleApp"
+
+includedirs {"../../src", naclambase}
+
+links {
+	"BulletDynamics","BulletCollision", "LinearMath"
+}
+
+language "C++"
+
+files {
+	"JsonReaderBenchmark.cpp",
+	naclambase .. "/NaClAMJsonReader.cpp",
+	naclambase .. "/jsoncpp.cpp",
+}
+
+project "AppJsonWriterBenchmark"
+
+kind "ConsoleApp"
+
+includedirs {"../../src", naclambase}
+
+links {
+	"BulletDynamics","BulletCollision", "LinearMath"
+}
+
+language "C++"
+
+files {
+	"JsonWriterBenchmark.cpp",
+	naclambase .. "/NaClAMJsonWriter.cpp",
+	naclambase .. "/jsoncpp.cpp",
+}
+
+end
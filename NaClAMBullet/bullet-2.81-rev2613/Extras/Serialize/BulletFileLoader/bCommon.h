@@ -32,7 +32,7 @@ namespace bParse {
 	// delete void* undefined
 	typedef struct bStructHandle {int unused;}bStructHandle;
 	typedef btAlignedObjectArray<bStructHandle*>	bListBasePtr;
-	typedef btHashMap<btHashPtr, bStructHandle*> bPtrMap;
+	typedef btFlatHashMap<btHashPtr, bStructHandle*> bPtrMap;
 }
 
 
@@ -823,12 +823,24 @@ void bFile::resolvePointersMismatch()
 
 	int i;
 
+	btAlignedObjectArray<btHashPtr> oldPtrs;
+	btAlignedObjectArray<bStructHandle**> newPtrs;
+	oldPtrs.reserve(m_pointerFixupArray.size());
+	newPtrs.resize(m_pointerFixupArray.size());
+	for (i=0;i<	m_pointerFixupArray.size();i++)
+	{
+		oldPtrs.push_back(*(void**)m_pointerFixupArray.at(i));
+	}
+	if (oldPtrs.size())
+	{
+		getLibPointers().findMany(&oldPtrs[0], oldPtrs.size(), &newPtrs[0]);
+	}
+
 	for (i=0;i<	m_pointerFixupArray.size();i++)
 	{
 		char* cur = m_pointerFixupArray.at(i);
 		void** ptrptr = (void**) cur;
-		void* ptr = *ptrptr;
-		ptr = findLibPointer(ptr);
+		void* ptr = newPtrs[i] ? *newPtrs[i] : 0;
 		if (ptr)
 		{
 			//printf("Fixup pointer!\n");
@@ -1180,10 +1192,23 @@ void	bFile::updateOldPointers()
 {
 	int i;
 
+	btAlignedObjectArray<btHashPtr> oldPtrs;
+	btAlignedObjectArray<bStructHandle**> newPtrs;
+	oldPtrs.reserve(m_chunks.size());
+	newPtrs.resize(m_chunks.size());
+	for (i=0;i<m_chunks.size();i++)
+	{
+		oldPtrs.push_back(m_chunks[i].oldPtr);
+	}
+	if (oldPtrs.size())
+	{
+		getLibPointers().findMany(&oldPtrs[0], oldPtrs.size(), &newPtrs[0]);
+	}
+
 	for (i=0;i<m_chunks.size();i++)
 	{
 		bChunkInd& dataChunk = m_chunks[i];
-		dataChunk.oldPtr = findLibPointer(dataChunk.oldPtr);
+		dataChunk.oldPtr = newPtrs[i] ? *newPtrs[i] : 0;
 	}
 }
 void	bFile::dumpChunks(bParse::bDNA* dna)
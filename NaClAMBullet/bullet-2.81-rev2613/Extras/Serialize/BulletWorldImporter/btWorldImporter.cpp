@@ -1357,6 +1357,9 @@ void	btWorldImporter::convertRigidBodyFloat( btRigidBodyFloatData* colObjData)
 		btRigidBody* body = createRigidBody(isDynamic,mass,startTransform,shape,colObjData->m_collisionObjectData.m_name);
 		body->setFriction(colObjData->m_collisionObjectData.m_friction);
 		body->setRestitution(colObjData->m_collisionObjectData.m_restitution);
+		body->setCcdMotionThreshold(colObjData->m_collisionObjectData.m_ccdMotionThreshold);
+		body->setCcdSweptSphereRadius(colObjData->m_collisionObjectData.m_ccdSweptSphereRadius);
+		body->setSleepingThresholds(colObjData->m_linearSleepingThreshold,colObjData->m_angularSleepingThreshold);
 				
 
 #ifdef USE_INTERNAL_EDGE_UTILITY
@@ -1402,6 +1405,9 @@ void	btWorldImporter::convertRigidBodyDouble( btRigidBodyDoubleData* colObjData)
 		btRigidBody* body = createRigidBody(isDynamic,mass,startTransform,shape,colObjData->m_collisionObjectData.m_name);
 		body->setFriction(colObjData->m_collisionObjectData.m_friction);
 		body->setRestitution(colObjData->m_collisionObjectData.m_restitution);
+		body->setCcdMotionThreshold(colObjData->m_collisionObjectData.m_ccdMotionThreshold);
+		body->setCcdSweptSphereRadius(colObjData->m_collisionObjectData.m_ccdSweptSphereRadius);
+		body->setSleepingThresholds(colObjData->m_linearSleepingThreshold,colObjData->m_angularSleepingThreshold);
 				
 
 #ifdef USE_INTERNAL_EDGE_UTILITY
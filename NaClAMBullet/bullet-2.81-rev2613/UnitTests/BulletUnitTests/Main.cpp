@@ -9,11 +9,13 @@
 #include "TestLinearMath.h"
 #include "TestPolarDecomposition.h"
 #include "TestCholeskyDecomposition.h"
+#include "TestFlatHashMap.h"
 
   CPPUNIT_TEST_SUITE_REGISTRATION( TestLinearMath );
   CPPUNIT_TEST_SUITE_REGISTRATION( TestBulletOnly );
   CPPUNIT_TEST_SUITE_REGISTRATION( TestPolarDecomposition );
   CPPUNIT_TEST_SUITE_REGISTRATION( TestCholeskyDecomposition );
+  CPPUNIT_TEST_SUITE_REGISTRATION( TestFlatHashMap );
 
 
 
@@ -0,0 +1,137 @@
+#ifndef TESTFLATHASHMAP_HAS_BEEN_INCLUDED
+#define TESTFLATHASHMAP_HAS_BEEN_INCLUDED
+
+#include "cppunit/TestFixture.h"
+#include "cppunit/extensions/HelperMacros.h"
+
+#include <map>
+#include <stdlib.h>
+
+#include "LinearMath/btHashMap.h"
+
+// ---------------------------------------------------------------------------
+
+class TestFlatHashMap : public CppUnit::TestFixture
+{
+	typedef btFlatHashMap<btHashInt,int>	FlatMap;
+	typedef std::map<int,int>				ReferenceMap;
+
+	///checks that every key in [0,range) is found in map exactly when it is in reference, with the same value
+	void checkSame(FlatMap& map, const ReferenceMap& reference, int range)
+	{
+		CPPUNIT_ASSERT_EQUAL( (int)reference.size(), map.size() );
+		for (int key=0;key<range;key++)
+		{
+			int* value = map.find(key);
+			ReferenceMap::const_iterator it = reference.find(key);
+			CPPUNIT_ASSERT_EQUAL( it==reference.end(), value==0 );
+			if (value)
+				CPPUNIT_ASSERT_EQUAL( it->second, *value );
+		}
+
+		// The packed values are the live ones, whatever was removed in between
+		long long sum = 0, referenceSum = 0;
+		for (int i=0;i<map.size();i++)
+			sum += *map.getAtIndex(i);
+		for (ReferenceMap::const_iterator it=reference.begin();it!=reference.end();++it)
+			referenceSum += it->second;
+		CPPUNIT_ASSERT_EQUAL( referenceSum, sum );
+	}
+
+public:
+
+	void setUp()
+	{
+	}
+
+	void tearDown()
+	{
+	}
+
+	void testRandomAgainstStdMap()
+	{
+		for (int round=0;round<20;round++)
+		{
+			srand(round);
+			// Small key ranges churn one group with removals, large ones grow the table
+			int range = (round%2) ? 50 : 5000;
+			FlatMap map;
+			ReferenceMap reference;
+			if (round%3==0)
+				map.reserve(rand()%3000);
+
+			for (int op=0;op<100000;op++)
+			{
+				int key = rand()%range;
+				switch (rand()%3)
+				{
+				case 0:
+					map.insert(key,op);
+					reference[key] = op;
+					break;
+				case 1:
+					map.remove(key);
+					reference.erase(key);
+					break;
+				default:
+					{
+						int* value = map.find(key);
+						ReferenceMap::iterator it = reference.find(key);
+						CPPUNIT_ASSERT_EQUAL( it==reference.end(), value==0 );
+						if (value)
+							CPPUNIT_ASSERT_EQUAL( it->second, *value );
+					}
+				}
+				CPPUNIT_ASSERT_EQUAL( (int)reference.size(), map.size() );
+			}
+			checkSame(map,reference,range);
+		}
+	}
+
+	void testFindManyMatchesFind()
+	{
+		srand(1);
+		FlatMap map;
+		for (int i=0;i<3000;i++)
+			map.insert(rand()%5000,i);
+		for (int i=0;i<1000;i++)
+			map.remove(rand()%5000);
+
+		// Batches larger than the prefetch batch, with missing and repeated keys
+		btAlignedObjectArray<btHashInt> keys;
+		for (int i=0;i<1000;i++)
+			keys.push_back(btHashInt(rand()%6000));
+		btAlignedObjectArray<int*> values;
+		values.resize(keys.size());
+		map.findMany(&keys[0],keys.size(),&values[0]);
+		for (int i=0;i<keys.size();i++)
+			CPPUNIT_ASSERT_EQUAL( map.find(keys[i]), values[i] );
+	}
+
+	void testClearAndReuse()
+	{
+		FlatMap map;
+		ReferenceMap reference;
+		for (int i=0;i<1000;i++)
+			map.insert(i,i);
+		map.clear();
+		checkSame(map,reference,1000);
+		for (int i=0;i<1000;i+=3)
+		{
+			map.insert(i,-i);
+			reference[i] = -i;
+		}
+		checkSame(map,reference,1000);
+	}
+
+	CPPUNIT_TEST_SUITE(TestFlatHashMap);
+	CPPUNIT_TEST(testRandomAgainstStdMap);
+	CPPUNIT_TEST(testFindManyMatchesFind);
+	CPPUNIT_TEST(testClearAndReuse);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+
+};
+
+#endif
@@ -190,9 +190,11 @@ end
 		include "../src/BulletCollision"	
 		include "../src/BulletDynamics"	
 		include "../src/BulletSoftBody"	
+		include "../src/BulletMultiThreaded"	
 	end
 	
 	include "../Test"
 	include "../Demos/HelloWorld"
+	include "../Demos/ConsoleBenchmarks"
 	include "../Demos/Benchmarks"
 	
@@ -231,6 +231,8 @@ BT_DECLARE_ALIGNED_ALLOCATOR();
 
 };
 
+BT_DECLARE_TRIVIALLY_RELOCATABLE(btBroadphasePair)
+
 /*
 //comparison for set operation, see Solid DT_Encounter
 SIMD_FORCE_INLINE bool operator<(const btBroadphasePair& a, const btBroadphasePair& b) 
@@ -646,6 +646,54 @@ void			btDbvt::extractLeaves(const btDbvtNode* node,btAlignedObjectArray<const b
 	}	
 }
 
+//
+void			btDbvt::splitTT(const btDbvtNode* root0,const btDbvtNode* root1,int depth,btAlignedObjectArray<sStkNN>& pairs)
+{
+	if(!root0||!root1) return;
+	// Children are visited in the reverse of the order collideTTpersistentStack
+	// pushes them, which is the order it pops them in
+	if(root0==root1)
+	{
+		if(root0->isinternal())
+		{
+			if(depth>0)
+			{
+				splitTT(root0->childs[0],root0->childs[1],depth-1,pairs);
+				splitTT(root0->childs[1],root0->childs[1],depth-1,pairs);
+				splitTT(root0->childs[0],root0->childs[0],depth-1,pairs);
+			}
+			else
+			{
+				pairs.push_back(sStkNN(root0,root1));
+			}
+		}
+	}
+	else if(Intersect(root0->volume,root1->volume))
+	{
+		if(depth>0&&root0->isinternal()&&root1->isinternal())
+		{
+			splitTT(root0->childs[1],root1->childs[1],depth-1,pairs);
+			splitTT(root0->childs[0],root1->childs[1],depth-1,pairs);
+			splitTT(root0->childs[1],root1->childs[0],depth-1,pairs);
+			splitTT(root0->childs[0],root1->childs[0],depth-1,pairs);
+		}
+		else if(depth>0&&root0->isinternal())
+		{
+			splitTT(root0->childs[1],root1,depth-1,pairs);
+			splitTT(root0->childs[0],root1,depth-1,pairs);
+		}
+		else if(depth>0&&root1->isinternal())
+		{
+			splitTT(root0,root1->childs[1],depth-1,pairs);
+			splitTT(root0,root1->childs[0],depth-1,pairs);
+		}
+		else
+		{
+			pairs.push_back(sStkNN(root0,root1));
+		}
+	}
+}
+
 //
 #if DBVT_ENABLE_BENCHMARK
 
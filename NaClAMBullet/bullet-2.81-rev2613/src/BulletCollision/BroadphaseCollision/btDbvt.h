@@ -286,6 +286,9 @@ struct	btDbvt
 	static int		maxdepth(const btDbvtNode* node);
 	static int		countLeaves(const btDbvtNode* node);
 	static void		extractLeaves(const btDbvtNode* node,btAlignedObjectArray<const btDbvtNode*>& leaves);
+	///splitTT appends the node pairs that collideTTpersistentStack(root0,root1) reaches depth levels below the root pair, and the leaf pairs it reaches above that depth, in the order it processes them.
+	///colliding each of them in turn with collideTTstack reports the same pairs in the same order, so they can be collided as independent tasks whose pairs are appended in task order.
+	static void		splitTT(const btDbvtNode* root0,const btDbvtNode* root1,int depth,btAlignedObjectArray<sStkNN>& pairs);
 #if DBVT_ENABLE_BENCHMARK
 	static void		benchmark();
 #else
@@ -307,6 +310,12 @@ struct	btDbvt
 		void		collideTTpersistentStack(	const btDbvtNode* root0,
 		  const btDbvtNode* root1,
 		  DBVT_IPOLICY);
+	///collideTTstack is collideTTpersistentStack on a stack owned by the caller, so subtree pairs of the same trees can be collided on different threads.
+	DBVT_PREFIX
+		static void		collideTTstack(	const btDbvtNode* root0,
+		  const btDbvtNode* root1,
+		  btAlignedObjectArray<sStkNN>& stack,
+		  DBVT_IPOLICY);
 #if 0
 	DBVT_PREFIX
 		void		collideTT(	const btDbvtNode* root0,
@@ -786,8 +795,9 @@ inline void		btDbvt::collideTT(	const btDbvtNode* root0,
 
 
 DBVT_PREFIX
-inline void		btDbvt::collideTTpersistentStack(	const btDbvtNode* root0,
+inline void		btDbvt::collideTTstack(	const btDbvtNode* root0,
 								  const btDbvtNode* root1,
+								  btAlignedObjectArray<sStkNN>& stack,
 								  DBVT_IPOLICY)
 {
 	DBVT_CHECKTYPE
@@ -796,22 +806,22 @@ inline void		btDbvt::collideTTpersistentStack(	const btDbvtNode* root0,
 			int								depth=1;
 			int								treshold=DOUBLE_STACKSIZE-4;
 			
-			m_stkStack.resize(DOUBLE_STACKSIZE);
-			m_stkStack[0]=sStkNN(root0,root1);
+			stack.resize(DOUBLE_STACKSIZE);
+			stack[0]=sStkNN(root0,root1);
 			do	{		
-				sStkNN	p=m_stkStack[--depth];
+				sStkNN	p=stack[--depth];
 				if(depth>treshold)
 				{
-					m_stkStack.resize(m_stkStack.size()*2);
-					treshold=m_stkStack.size()-4;
+					stack.resize(stack.size()*2);
+					treshold=stack.size()-4;
 				}
 				if(p.a==p.b)
 				{
 					if(p.a->isinternal())
 					{
-						m_stkStack[depth++]=sStkNN(p.a->childs[0],p.a->childs[0]);
-						m_stkStack[depth++]=sStkNN(p.a->childs[1],p.a->childs[1]);
-						m_stkStack[depth++]=sStkNN(p.a->childs[0],p.a->childs[1]);
+						stack[depth++]=sStkNN(p.a->childs[0],p.a->childs[0]);
+						stack[depth++]=sStkNN(p.a->childs[1],p.a->childs[1]);
+						stack[depth++]=sStkNN(p.a->childs[0],p.a->childs[1]);
 					}
 				}
 				else if(Intersect(p.a->volume,p.b->volume))
@@ -820,23 +830,23 @@ inline void		btDbvt::collideTTpersistentStack(	const btDbvtNode* root0,
 					{
 						if(p.b->isinternal())
 						{
-							m_stkStack[depth++]=sStkNN(p.a->childs[0],p.b->childs[0]);
-							m_stkStack[depth++]=sStkNN(p.a->childs[1],p.b->childs[0]);
-							m_stkStack[depth++]=sStkNN(p.a->childs[0],p.b->childs[1]);
-							m_stkStack[depth++]=sStkNN(p.a->childs[1],p.b->childs[1]);
+							stack[depth++]=sStkNN(p.a->childs[0],p.b->childs[0]);
+							stack[depth++]=sStkNN(p.a->childs[1],p.b->childs[0]);
+							stack[depth++]=sStkNN(p.a->childs[0],p.b->childs[1]);
+							stack[depth++]=sStkNN(p.a->childs[1],p.b->childs[1]);
 						}
 						else
 						{
-							m_stkStack[depth++]=sStkNN(p.a->childs[0],p.b);
-							m_stkStack[depth++]=sStkNN(p.a->childs[1],p.b);
+							stack[depth++]=sStkNN(p.a->childs[0],p.b);
+							stack[depth++]=sStkNN(p.a->childs[1],p.b);
 						}
 					}
 					else
 					{
 						if(p.b->isinternal())
 						{
-							m_stkStack[depth++]=sStkNN(p.a,p.b->childs[0]);
-							m_stkStack[depth++]=sStkNN(p.a,p.b->childs[1]);
+							stack[depth++]=sStkNN(p.a,p.b->childs[0]);
+							stack[depth++]=sStkNN(p.a,p.b->childs[1]);
 						}
 						else
 						{
@@ -848,6 +858,15 @@ inline void		btDbvt::collideTTpersistentStack(	const btDbvtNode* root0,
 		}
 }
 
+DBVT_PREFIX
+inline void		btDbvt::collideTTpersistentStack(	const btDbvtNode* root0,
+								  const btDbvtNode* root1,
+								  DBVT_IPOLICY)
+{
+	DBVT_CHECKTYPE
+		collideTTstack(root0,root1,m_stkStack,policy);
+}
+
 #if 0
 //
 DBVT_PREFIX
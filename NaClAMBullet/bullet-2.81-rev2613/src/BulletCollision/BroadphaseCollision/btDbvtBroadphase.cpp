@@ -114,6 +114,95 @@ struct	btDbvtTreeCollider : btDbvt::ICollide
 	}
 };
 
+/* Stale pair collider	*/ 
+struct	btDbvtStaleCollider : btDbvt::ICollide
+{
+	btDbvtBroadphase*	pbp;
+	btDispatcher*		dispatcher;
+	btDbvtStaleCollider(btDbvtBroadphase* p,btDispatcher* d) : pbp(p),dispatcher(d) {}
+	void	Remove(btDbvtProxy* pa,btDbvtProxy* pb)
+	{
+#if DBVT_BP_SORTPAIRS
+		if(pa->m_uniqueId>pb->m_uniqueId) 
+			btSwap(pa,pb);
+#endif
+		pbp->m_paircache->removeOverlappingPair(pa,pb,dispatcher);
+	}
+	void	Process(const btDbvtNode* na,const btDbvtNode* nb)
+	{
+		btDbvtProxy*	pa=(btDbvtProxy*)na->data;
+		btDbvtProxy*	pb=(btDbvtProxy*)nb->data;
+		if(!Intersect(pa->leaf->volume,pb->leaf->volume))
+			Remove(pa,pb);
+	}
+};
+
+/* Stale pair collider for set leaves, pairs of two recorded proxies are left to the tree of their unions	*/ 
+struct	btDbvtUnrecordedCollider : btDbvtStaleCollider
+{
+	btDbvtUnrecordedCollider(btDbvtBroadphase* p,btDispatcher* d) : btDbvtStaleCollider(p,d) {}
+	void	Process(const btDbvtNode* na,const btDbvtNode* nb)
+	{
+		btDbvtProxy*	pa=(btDbvtProxy*)na->data;
+		if(pa->changed!=pbp->m_pid||pa->changedindex<0)
+			btDbvtStaleCollider::Process(na,nb);
+	}
+};
+
+/* Update collider, pairs a moved proxy with the leaves its new leaf overlaps and keeps the other leaves its old leaf overlapped for the clean up	*/ 
+struct	btDbvtUpdateCollider : btDbvt::ICollide
+{
+	btDbvtBroadphase*	pbp;
+	btDbvtUpdateCollider(btDbvtBroadphase* p) : pbp(p) {}
+	void	Process(const btDbvtNode* na,const btDbvtNode* nb)
+	{
+		btDbvtProxy*	pa=(btDbvtProxy*)na->data;
+		btDbvtProxy*	pb=(btDbvtProxy*)nb->data;
+		if(pa!=pb)
+		{
+			if(Intersect(na->volume,pb->leaf->volume))
+			{
+#if DBVT_BP_SORTPAIRS
+				if(pa->m_uniqueId>pb->m_uniqueId) 
+					btSwap(pa,pb);
+#endif
+				pbp->m_paircache->addOverlappingPair(pa,pb);
+				++pbp->m_newpairs;
+			}
+			else
+			{
+				pbp->m_separatedpairs.push_back(btBroadphasePair(*pa,*pb));
+			}
+		}
+	}
+};
+
+/* Collect collider	*/ 
+struct	btDbvtCollectCollider : btDbvt::ICollide
+{
+	btAlignedObjectArray<btDbvt::sStkNN>&	pairs;
+	btDbvtCollectCollider(btAlignedObjectArray<btDbvt::sStkNN>& p) : pairs(p) {}
+	void	Process(const btDbvtNode* na,const btDbvtNode* nb)
+	{
+		pairs.push_back(btDbvt::sStkNN(na,nb));
+	}
+};
+
+//
+// btDbvtCollideBatch
+//
+
+//
+void							btDbvtCollideBatch::process()
+{
+	btDbvtCollectCollider	collider(m_pairs);
+	m_pairs.resize(0);
+	for(int i=0;i<m_numtasks;++i)
+	{
+		btDbvt::collideTTstack(m_tasks[i].a,m_tasks[i].b,m_stack,collider);
+	}
+}
+
 //
 // btDbvtBroadphase
 //
@@ -122,14 +211,23 @@ struct	btDbvtTreeCollider : btDbvt::ICollide
 btDbvtBroadphase::btDbvtBroadphase(btOverlappingPairCache* paircache)
 {
 	m_deferedcollide	=	false;
+	m_splitdepth		=	0;
+	m_splitbatches		=	0;
 	m_needcleanup		=	true;
 	m_releasepaircache	=	(paircache!=0)?false:true;
 	m_prediction		=	0;
+#ifdef DBVT_BP_MARGIN
+	m_margin			=	DBVT_BP_MARGIN;
+#else
+	m_margin			=	0;
+#endif
+	m_moves_call		=	0;
+	m_moves_skipped		=	0;
+	m_leafchanges		=	0;
 	m_stageCurrent		=	0;
 	m_fixedleft			=	0;
 	m_fupdates			=	1;
 	m_dupdates			=	0;
-	m_cupdates			=	10;
 	m_newpairs			=	1;
 	m_updates_call		=	0;
 	m_updates_done		=	0;
@@ -137,7 +235,6 @@ btDbvtBroadphase::btDbvtBroadphase(btOverlappingPairCache* paircache)
 	m_paircache			=	paircache? paircache	: new(btAlignedAlloc(sizeof(btHashedOverlappingPairCache),16)) btHashedOverlappingPairCache();
 	m_gid				=	0;
 	m_pid				=	0;
-	m_cid				=	0;
 	for(int i=0;i<=STAGECOUNT;++i)
 	{
 		m_stageRoots[i]=0;
@@ -177,6 +274,8 @@ btBroadphaseProxy*				btDbvtBroadphase::createProxy(	const btVector3& aabbMin,
 	proxy->stage		=	m_stageCurrent;
 	proxy->m_uniqueId	=	++m_gid;
 	proxy->leaf			=	m_sets[0].insert(aabb,proxy);
+	leafChanged(proxy,proxy->leaf->volume,true);
+	++m_leafchanges;
 	listappend(proxy,m_stageRoots[m_stageCurrent]);
 	if(!m_deferedcollide)
 	{
@@ -198,6 +297,16 @@ void							btDbvtBroadphase::destroyProxy(	btBroadphaseProxy* absproxy,
 	else
 		m_sets[0].remove(proxy->leaf);
 	listremove(proxy,m_stageRoots[proxy->stage]);
+	if(proxy->changed==m_pid&&proxy->changedindex>=0)
+		m_changedproxies[proxy->changedindex]=0;
+	for(int i=m_separatedpairs.size()-1;i>=0;--i)
+	{
+		if(m_separatedpairs[i].m_pProxy0==proxy||m_separatedpairs[i].m_pProxy1==proxy)
+		{
+			m_separatedpairs.swap(i,m_separatedpairs.size()-1);
+			m_separatedpairs.pop_back();
+		}
+	}
 	m_paircache->removeOverlappingPairsContainingProxy(proxy,dispatcher);
 	btAlignedFree(proxy);
 	m_needcleanup=true;
@@ -290,7 +399,9 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 	if(NotEqual(aabb,proxy->leaf->volume))
 #endif
 	{
+		ATTRIBUTE_ALIGNED16(btDbvtVolume)	oldvolume=proxy->leaf->volume;
 		bool	docollide=false;
+		++m_moves_call;
 		if(proxy->stage==STAGECOUNT)
 		{/* fixed -> dynamic set	*/ 
 			m_sets[1].remove(proxy->leaf);
@@ -308,13 +419,7 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 				if(delta[0]<0) velocity[0]=-velocity[0];
 				if(delta[1]<0) velocity[1]=-velocity[1];
 				if(delta[2]<0) velocity[2]=-velocity[2];
-				if	(
-#ifdef DBVT_BP_MARGIN				
-					m_sets[0].update(proxy->leaf,aabb,velocity,DBVT_BP_MARGIN)
-#else
-					m_sets[0].update(proxy->leaf,aabb,velocity)
-#endif
-					)
+				if(m_sets[0].update(proxy->leaf,aabb,velocity,m_margin))
 				{
 					++m_updates_done;
 					docollide=true;
@@ -334,14 +439,17 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 		listappend(proxy,m_stageRoots[m_stageCurrent]);
 		if(docollide)
 		{
-			m_needcleanup=true;
+			++m_leafchanges;
 			if(!m_deferedcollide)
 			{
-				btDbvtTreeCollider	collider(this);
-				m_sets[1].collideTTpersistentStack(m_sets[1].m_root,proxy->leaf,collider);
-				m_sets[0].collideTTpersistentStack(m_sets[0].m_root,proxy->leaf,collider);
+				updatePairs(proxy,oldvolume);
 			}
-		}	
+			leafChanged(proxy,oldvolume,!m_deferedcollide);
+		}
+		else
+		{/* Inside its leaf		*/ 
+			++m_moves_skipped;
+		}
 	}
 }
 
@@ -354,7 +462,9 @@ void							btDbvtBroadphase::setAabbForceUpdate(		btBroadphaseProxy* absproxy,
 {
 	btDbvtProxy*						proxy=(btDbvtProxy*)absproxy;
 	ATTRIBUTE_ALIGNED16(btDbvtVolume)	aabb=btDbvtVolume::FromMM(aabbMin,aabbMax);
+	ATTRIBUTE_ALIGNED16(btDbvtVolume)	oldvolume=proxy->leaf->volume;
 	bool	docollide=false;
+	++m_moves_call;
 	if(proxy->stage==STAGECOUNT)
 	{/* fixed -> dynamic set	*/ 
 		m_sets[1].remove(proxy->leaf);
@@ -376,13 +486,12 @@ void							btDbvtBroadphase::setAabbForceUpdate(		btBroadphaseProxy* absproxy,
 	listappend(proxy,m_stageRoots[m_stageCurrent]);
 	if(docollide)
 	{
-		m_needcleanup=true;
+		++m_leafchanges;
 		if(!m_deferedcollide)
 		{
-			btDbvtTreeCollider	collider(this);
-			m_sets[1].collideTTpersistentStack(m_sets[1].m_root,proxy->leaf,collider);
-			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,proxy->leaf,collider);
+			updatePairs(proxy,oldvolume);
 		}
+		leafChanged(proxy,oldvolume,!m_deferedcollide);
 	}	
 }
 
@@ -430,6 +539,9 @@ void btDbvtBroadphase::performDeferredRemoval(btDispatcher* dispatcher)
 		
 		int i;
 
+		//collide has already moved on to the next parse id, pairs of proxies whose leaf did not change in the last one still overlap
+		const int changedPid = m_pid-1;
+
 		btBroadphasePair previousPair;
 		previousPair.m_pProxy0 = 0;
 		previousPair.m_pProxy1 = 0;
@@ -452,7 +564,7 @@ void btDbvtBroadphase::performDeferredRemoval(btDispatcher* dispatcher)
 				//important to perform AABB check that is consistent with the broadphase
 				btDbvtProxy*		pa=(btDbvtProxy*)pair.m_pProxy0;
 				btDbvtProxy*		pb=(btDbvtProxy*)pair.m_pProxy1;
-				bool hasOverlap = Intersect(pa->leaf->volume,pb->leaf->volume);
+				bool hasOverlap = (pa->changed!=changedPid && pb->changed!=changedPid) || Intersect(pa->leaf->volume,pb->leaf->volume);
 
 				if (hasOverlap)
 				{
@@ -486,6 +598,46 @@ void btDbvtBroadphase::performDeferredRemoval(btDispatcher* dispatcher)
 	}
 }
 
+//
+void							btDbvtBroadphase::leafChanged(btDbvtProxy* proxy,const btDbvtVolume& oldvolume,bool updated)
+{
+	if(proxy->changed!=m_pid)
+	{
+		proxy->changed		=	m_pid;
+		proxy->changedindex	=	-1;
+	}
+	// While recorded proxies wait for the clean up, a proxy whose pairs were
+	// updated can still be in a stale pair with one of them, so it is
+	// recorded too and the tree of unions finds that pair
+	if(proxy->changedindex<0&&(!updated||m_changedproxies.size()>0))
+	{
+		proxy->changedindex	=	m_changedproxies.size();
+		m_changedproxies.push_back(proxy);
+		m_changedvolumes.push_back(oldvolume);
+	}
+	if(proxy->changedindex>=0)
+	{
+		btDbvtVolume&	volume=m_changedvolumes[proxy->changedindex];
+		Merge(volume,proxy->leaf->volume,volume);
+		m_needcleanup=true;
+	}
+}
+
+//
+void							btDbvtBroadphase::updatePairs(btDbvtProxy* proxy,const btDbvtVolume& oldvolume)
+{
+	btDbvtNode	node;
+	Merge(oldvolume,proxy->leaf->volume,node.volume);
+	node.parent		=	0;
+	node.data		=	proxy;
+	node.childs[1]	=	0;
+	btDbvtUpdateCollider	collider(this);
+	m_sets[1].collideTTpersistentStack(m_sets[1].m_root,&node,collider);
+	m_sets[0].collideTTpersistentStack(m_sets[0].m_root,&node,collider);
+	if(m_separatedpairs.size()>0)
+		m_needcleanup=true;
+}
+
 //
 void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 {
@@ -531,59 +683,97 @@ void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 			btDbvt::collideTV(m_sets[0].m_root,current->aabb,collider);
 			btDbvt::collideTV(m_sets[1].m_root,current->aabb,collider);
 #endif
+			ATTRIBUTE_ALIGNED16(btDbvtVolume)	oldvolume=current->leaf->volume;
 			m_sets[0].remove(current->leaf);
 			ATTRIBUTE_ALIGNED16(btDbvtVolume)	curAabb=btDbvtVolume::FromMM(current->m_aabbMin,current->m_aabbMax);
 			current->leaf	=	m_sets[1].insert(curAabb,current);
 			current->stage	=	STAGECOUNT;	
+			leafChanged(current,oldvolume,false);
 			current			=	next;
 		} while(current);
 		m_fixedleft=m_sets[1].m_leaves;
 		m_needcleanup=true;
 	}
 	/* collide dynamics		*/ 
-	{
-		btDbvtTreeCollider	collider(this);
+	if(m_leafchanges>0)
+	{/* pairs only appear where a leaf was inserted or updated	*/ 
 		if(m_deferedcollide)
 		{
 			SPC(m_profiling.m_fdcollide);
-			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,m_sets[1].m_root,collider);
+			collideTT(m_sets[0].m_root,m_sets[1].m_root);
 		}
 		if(m_deferedcollide)
 		{
 			SPC(m_profiling.m_ddcollide);
-			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,m_sets[0].m_root,collider);
+			collideTT(m_sets[0].m_root,m_sets[0].m_root);
 		}
 	}
 	/* clean up				*/ 
 	if(m_needcleanup)
 	{
 		SPC(m_profiling.m_cleanup);
+		// A pair can only have stopped overlapping if updatePairs separated
+		// it or it has a recorded proxy. The other leaf of such a pair then
+		// overlaps the union of the leaves that proxy had since the last
+		// clean up. While few proxies are recorded, their unions are collided
+		// with the other leaves in the sets and with each other, else every
+		// pair with a changed proxy is tested
+		btDbvtStaleCollider	stale(this,dispatcher);
+		for(int i=0;i<m_separatedpairs.size();++i)
+		{
+			btDbvtProxy*	pa=(btDbvtProxy*)m_separatedpairs[i].m_pProxy0;
+			btDbvtProxy*	pb=(btDbvtProxy*)m_separatedpairs[i].m_pProxy1;
+			if(!Intersect(pa->leaf->volume,pb->leaf->volume))
+				stale.Remove(pa,pb);
+		}
 		btBroadphasePairArray&	pairs=m_paircache->getOverlappingPairArray();
-		if(pairs.size()>0)
+		if(m_changedproxies.size()*DBVT_BP_CLEANUPQUERYPAIRS<pairs.size())
 		{
-
-			int			ni=btMin(pairs.size(),btMax<int>(m_newpairs,(pairs.size()*m_cupdates)/100));
-			for(int i=0;i<ni;++i)
+			btDbvtUnrecordedCollider	unrecorded(this,dispatcher);
+			for(int i=0;i<m_changedproxies.size();++i)
 			{
-				btBroadphasePair&	p=pairs[(m_cid+i)%pairs.size()];
+				btDbvtProxy*	proxy=m_changedproxies[i];
+				if(proxy)
+				{
+					btDbvtNode	node;
+					node.volume		=	m_changedvolumes[i];
+					node.parent		=	0;
+					node.data		=	proxy;
+					node.childs[1]	=	0;
+					m_sets[0].collideTTpersistentStack(m_sets[0].m_root,&node,unrecorded);
+					m_sets[1].collideTTpersistentStack(m_sets[1].m_root,&node,unrecorded);
+					m_changedtree.insert(m_changedvolumes[i],proxy);
+				}
+			}
+			m_changedtree.collideTTpersistentStack(m_changedtree.m_root,m_changedtree.m_root,stale);
+			m_changedtree.clear();
+		}
+		else
+		{
+			for(int i=0;i<pairs.size();++i)
+			{
+				btBroadphasePair&	p=pairs[i];
 				btDbvtProxy*		pa=(btDbvtProxy*)p.m_pProxy0;
 				btDbvtProxy*		pb=(btDbvtProxy*)p.m_pProxy1;
-				if(!Intersect(pa->leaf->volume,pb->leaf->volume))
+				if((pa->changed==m_pid||pb->changed==m_pid)&&!Intersect(pa->leaf->volume,pb->leaf->volume))
 				{
 #if DBVT_BP_SORTPAIRS
 					if(pa->m_uniqueId>pb->m_uniqueId) 
 						btSwap(pa,pb);
 #endif
 					m_paircache->removeOverlappingPair(pa,pb,dispatcher);
-					--ni;--i;
+					--i;
 				}
 			}
-			if(pairs.size()>0) m_cid=(m_cid+ni)%pairs.size(); else m_cid=0;
 		}
 	}
+	m_changedproxies.resize(0);
+	m_changedvolumes.resize(0);
+	m_separatedpairs.resize(0);
 	++m_pid;
 	m_newpairs=1;
 	m_needcleanup=false;
+	m_leafchanges=0;
 	if(m_updates_call>0)
 	{ m_updates_ratio=m_updates_done/(btScalar)m_updates_call; }
 	else
@@ -592,6 +782,50 @@ void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 	m_updates_call/=2;
 }
 
+//
+void							btDbvtBroadphase::collideTT(const btDbvtNode* root0,const btDbvtNode* root1)
+{
+	btDbvtTreeCollider	collider(this);
+	if(m_splitdepth<=0||m_splitbatches<=0)
+	{
+		m_sets[0].collideTTpersistentStack(root0,root1,collider);
+		return;
+	}
+	m_collidetasks.resize(0);
+	btDbvt::splitTT(root0,root1,m_splitdepth,m_collidetasks);
+	const int	ntasks=m_collidetasks.size();
+	const int	nbatches=btMin(m_splitbatches,ntasks);
+	if(nbatches==0) return;
+	if(m_collidebatches.size()<nbatches) m_collidebatches.resize(nbatches);
+	for(int i=0;i<nbatches;++i)
+	{
+		// Contiguous runs of tasks, so appending the batches in order keeps
+		// the pair order of the serial collide
+		const int	begin=(ntasks*i)/nbatches;
+		const int	end=(ntasks*(i+1))/nbatches;
+		m_collidebatches[i].m_tasks		=	&m_collidetasks[begin];
+		m_collidebatches[i].m_numtasks	=	end-begin;
+	}
+	collideBatches(&m_collidebatches[0],nbatches);
+	for(int i=0;i<nbatches;++i)
+	{
+		const btAlignedObjectArray<btDbvt::sStkNN>&	pairs=m_collidebatches[i].m_pairs;
+		for(int j=0;j<pairs.size();++j)
+		{
+			collider.Process(pairs[j].a,pairs[j].b);
+		}
+	}
+}
+
+//
+void							btDbvtBroadphase::collideBatches(btDbvtCollideBatch* batches,int numBatches)
+{
+	for(int i=0;i<numBatches;++i)
+	{
+		batches[i].process();
+	}
+}
+
 //
 void							btDbvtBroadphase::optimize()
 {
@@ -645,15 +879,19 @@ void btDbvtBroadphase::resetPool(btDispatcher* dispatcher)
 		m_fixedleft			=	0;
 		m_fupdates			=	1;
 		m_dupdates			=	0;
-		m_cupdates			=	10;
 		m_newpairs			=	1;
 		m_updates_call		=	0;
 		m_updates_done		=	0;
 		m_updates_ratio		=	0;
+		m_moves_call		=	0;
+		m_moves_skipped		=	0;
+		m_leafchanges		=	0;
 		
 		m_gid				=	0;
 		m_pid				=	0;
-		m_cid				=	0;
+		m_changedproxies.resize(0);
+		m_changedvolumes.resize(0);
+		m_separatedpairs.resize(0);
 		for(int i=0;i<=STAGECOUNT;++i)
 		{
 			m_stageRoots[i]=0;
@@ -661,6 +899,39 @@ void btDbvtBroadphase::resetPool(btDispatcher* dispatcher)
 	}
 }
 
+//
+void							btDbvtBroadphase::rebuild(btBroadphaseProxy** proxies,int numProxies,btDispatcher* dispatcher)
+{
+	int i;
+	for(i=0;i<numProxies;++i)
+	{
+		btDbvtProxy*	proxy=(btDbvtProxy*)proxies[i];
+		m_paircache->removeOverlappingPairsContainingProxy(proxy,dispatcher);
+		if(proxy->stage==STAGECOUNT)
+			m_sets[1].remove(proxy->leaf);
+		else
+			m_sets[0].remove(proxy->leaf);
+		listremove(proxy,m_stageRoots[proxy->stage]);
+	}
+	m_stageCurrent		=	0;
+	m_fixedleft			=	0;
+	m_newpairs			=	1;
+	m_sets[0].m_opath	=	0;
+	m_sets[1].m_opath	=	0;
+	for(i=0;i<numProxies;++i)
+	{
+		btDbvtProxy*						proxy=(btDbvtProxy*)proxies[i];
+		ATTRIBUTE_ALIGNED16(btDbvtVolume)	aabb=btDbvtVolume::FromMM(proxy->m_aabbMin,proxy->m_aabbMax);
+		proxy->leaf		=	m_sets[0].insert(aabb,proxy);
+		proxy->stage	=	m_stageCurrent;
+		leafChanged(proxy,proxy->leaf->volume,true);
+		listappend(proxy,m_stageRoots[m_stageCurrent]);
+	}
+	collideTT(m_sets[0].m_root,m_sets[0].m_root);
+	collideTT(m_sets[0].m_root,m_sets[1].m_root);
+	m_needcleanup=true;
+}
+
 //
 void							btDbvtBroadphase::printStats()
 {}
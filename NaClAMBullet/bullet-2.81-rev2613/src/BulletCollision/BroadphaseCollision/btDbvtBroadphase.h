@@ -30,6 +30,7 @@ subject to the following restrictions:
 #define DBVT_BP_ACCURATESLEEPING		0
 #define DBVT_BP_ENABLE_BENCHMARK		0
 #define DBVT_BP_MARGIN					(btScalar)0.05
+#define DBVT_BP_CLEANUPQUERYPAIRS		2000
 
 #if DBVT_BP_PROFILE
 #define	DBVT_BP_PROFILING_RATE	256
@@ -46,16 +47,36 @@ struct btDbvtProxy : btBroadphaseProxy
 	btDbvtNode*		leaf;
 	btDbvtProxy*	links[2];
 	int				stage;
+	int				changed;	// Parse id of the last collide the leaf changed before
+	int				changedindex;	// Index in the broadphase's changed proxies while changed is the current parse id, -1 if not recorded
 	/* ctor			*/ 
 	btDbvtProxy(const btVector3& aabbMin,const btVector3& aabbMax,void* userPtr,short int collisionFilterGroup, short int collisionFilterMask) :
 	btBroadphaseProxy(aabbMin,aabbMax,userPtr,collisionFilterGroup,collisionFilterMask)
 	{
 		links[0]=links[1]=0;
+		changed=-1;
+		changedindex=-1;
 	}
 };
 
 typedef btAlignedObjectArray<btDbvtProxy*>	btDbvtProxyArray;
 
+//
+// btDbvtCollideBatch
+//
+struct btDbvtCollideBatch
+{
+	/* Fields		*/ 
+	const btDbvt::sStkNN*					m_tasks;	// Subtree pairs to collide, in order
+	int										m_numtasks;	// Number of subtree pairs
+	btAlignedObjectArray<btDbvt::sStkNN>	m_stack;	// Traversal stack
+	btAlignedObjectArray<btDbvt::sStkNN>	m_pairs;	// Overlapping leaf pairs found, in order
+	/* Methods		*/ 
+	btDbvtCollideBatch() : m_tasks(0),m_numtasks(0) {}
+	///collides the subtree pairs of the batch and collects their overlapping leaf pairs, it only writes to the batch so batches can be collided on different threads.
+	void	process();
+};
+
 ///The btDbvtBroadphase implements a broadphase using two dynamic AABB bounding volume hierarchies/trees (see btDbvt).
 ///One tree is used for static/non-moving objects, and another tree is used for dynamic objects. Objects can move from one tree to the other.
 ///This is a very fast broadphase, especially for very dynamic worlds where many objects are moving. Its insert/add and remove of objects is generally faster than the sweep and prune broadphases btAxisSweep3 and bt32BitAxisSweep3.
@@ -72,21 +93,31 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	btDbvtProxy*			m_stageRoots[STAGECOUNT+1];	// Stages list
 	btOverlappingPairCache*	m_paircache;				// Pair cache
 	btScalar				m_prediction;				// Velocity prediction
+	btScalar				m_margin;					// Margin moving dynamic leaves are enlarged by
 	int						m_stageCurrent;				// Current stage
 	int						m_fupdates;					// % of fixed updates per frame
 	int						m_dupdates;					// % of dynamic updates per frame
-	int						m_cupdates;					// % of cleanup updates per frame
 	int						m_newpairs;					// Number of pairs created
 	int						m_fixedleft;				// Fixed optimization left
 	unsigned				m_updates_call;				// Number of updates call
 	unsigned				m_updates_done;				// Number of updates done
 	btScalar				m_updates_ratio;			// m_updates_done/m_updates_call
+	unsigned				m_moves_call;				// setAabb calls since the counts were cleared
+	unsigned				m_moves_skipped;			// Calls that stayed inside the proxy's leaf
+	int						m_leafchanges;				// Leaf inserts and updates since the last collide
 	int						m_pid;						// Parse id
-	int						m_cid;						// Cleanup index
 	int						m_gid;						// Gen id
 	bool					m_releasepaircache;			// Release pair cache on delete
 	bool					m_deferedcollide;			// Defere dynamic/static collision to collide call
 	bool					m_needcleanup;				// Need to run cleanup?
+	int						m_splitdepth;				// Depth tree/tree collides split at, 0 to collide serially
+	int						m_splitbatches;				// Batches the split subtree pairs are collided in
+	btAlignedObjectArray<btDbvt::sStkNN>	m_collidetasks;	// Subtree pairs of a split collide
+	btAlignedObjectArray<btDbvtCollideBatch>	m_collidebatches;	// Batches of a split collide
+	btAlignedObjectArray<btDbvtProxy*>	m_changedproxies;	// Changed proxies whose pairs the next clean up tests, 0 once destroyed
+	btAlignedObjectArray<btDbvtVolume>	m_changedvolumes;	// Union of the leaves each of them had since the last clean up
+	btDbvt					m_changedtree;				// Tree of those unions, built by the clean up
+	btBroadphasePairArray	m_separatedpairs;			// Pairs updatePairs found the new leaf of a moved proxy no longer overlaps
 #if DBVT_BP_PROFILE
 	btClock					m_clock;
 	struct	{
@@ -101,6 +132,11 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	btDbvtBroadphase(btOverlappingPairCache* paircache=0);
 	~btDbvtBroadphase();
 	void							collide(btDispatcher* dispatcher);
+	///collideTT adds the overlapping pairs of two subtrees of the sets to the pair cache. with m_splitdepth set the subtree pairs at that depth are divided into m_splitbatches
+	///batches in order and collided by collideBatches, the pairs of each batch are then added in batch order, so the pairs and their order do not depend on the split.
+	void							collideTT(const btDbvtNode* root0,const btDbvtNode* root1);
+	///collideBatches collides the batches of a split collide one after another, btParallelDbvtBroadphase collides them on worker threads.
+	virtual void					collideBatches(btDbvtCollideBatch* batches,int numBatches);
 	void							optimize();
 	
 	/* btBroadphaseInterface Implementation	*/
@@ -121,7 +157,19 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	///reset broadphase internal structures, to ensure determinism/reproducability
 	virtual void resetPool(btDispatcher* dispatcher);
 
+	///removes the proxies from the trees and pair cache, then inserts them again in the given order using their current aabbs and finds all their overlapping pairs.
+	///tree layout and pair order then only depend on the proxy order, so a world restored from a saved state simulates the same way every time it is restored.
+	void	rebuild(btBroadphaseProxy** proxies,int numProxies,btDispatcher* dispatcher);
+
 	void	performDeferredRemoval(btDispatcher* dispatcher);
+
+	///leafChanged records that the leaf of proxy was inserted or changed from oldvolume. updated tells that the proxy has no stale pairs the clean up
+	///does not know of, as it was just inserted or updatePairs kept them in m_separatedpairs. else the proxy is recorded and the clean up in collide
+	///tests its pairs against the leaves that overlap the union of the leaves it had since the last clean up.
+	void	leafChanged(btDbvtProxy* proxy,const btDbvtVolume& oldvolume,bool updated);
+	///updatePairs collides the union of the old and new leaf of a moved proxy with the sets, it adds the pairs the new leaf overlaps and keeps the others
+	///in m_separatedpairs. they are removed by the clean up if they still do not overlap then, so their algorithms survive moves that separate them briefly.
+	void	updatePairs(btDbvtProxy* proxy,const btDbvtVolume& oldvolume);
 	
 	void	setVelocityPrediction(btScalar prediction)
 	{
@@ -132,6 +180,23 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 		return m_prediction;
 	}
 
+	///setMargin sets how far a dynamic leaf is enlarged past the aabb of a proxy that moved out of it. proxies that move inside their leaf
+	///cause no tree update, pair search or clean up, so a larger margin skips more moves at the cost of more pairs for the narrowphase.
+	void	setMargin(btScalar margin)
+	{
+		m_margin = margin;
+	}
+	btScalar getMargin() const
+	{
+		return m_margin;
+	}
+
+	///getSkippedMoves returns the percentage of setAabb calls since m_moves_call and m_moves_skipped were cleared that stayed inside the proxy's leaf.
+	btScalar getSkippedMoves() const
+	{
+		return m_moves_call>0 ? (m_moves_skipped*btScalar(100))/m_moves_call : btScalar(0);
+	}
+
 	///this setAabbForceUpdate is similar to setAabb but always forces the aabb update. 
 	///it is not part of the btBroadphaseInterface but specific to btDbvtBroadphase.
 	///it bypasses certain optimizations that prevent aabb updates (when the aabb shrinks), see
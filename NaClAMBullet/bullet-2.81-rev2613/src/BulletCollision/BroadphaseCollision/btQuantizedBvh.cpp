@@ -1035,6 +1035,10 @@ btQuantizedBvh *btQuantizedBvh::deSerializeInPlace(void *i_alignedDataBuffer, un
 	{
 		return NULL;
 	}
+	if (i_dataBufferSize < sizeof(btQuantizedBvh))
+	{
+		return NULL;
+	}
 	btQuantizedBvh *bvh = (btQuantizedBvh *)i_alignedDataBuffer;
 
 	if (i_swapEndian)
@@ -1049,6 +1053,15 @@ btQuantizedBvh *btQuantizedBvh::deSerializeInPlace(void *i_alignedDataBuffer, un
 		bvh->m_subtreeHeaderCount = static_cast<int>(btSwapEndian(bvh->m_subtreeHeaderCount));
 	}
 
+	//the counts come from the buffer, reject them before calculateSerializeBufferSize can wrap around
+	unsigned int nodeSize = bvh->m_useQuantization ? sizeof(btQuantizedBvhNode) : sizeof(btOptimizedBvhNode);
+	if (bvh->m_curNodeIndex < 0 || bvh->m_subtreeHeaderCount < 0 ||
+		unsigned(bvh->m_curNodeIndex) > i_dataBufferSize / nodeSize ||
+		unsigned(bvh->m_subtreeHeaderCount) > (i_dataBufferSize - unsigned(bvh->m_curNodeIndex) * nodeSize) / sizeof(btBvhSubtreeInfo))
+	{
+		return NULL;
+	}
+
 	unsigned int calculatedBufSize = bvh->calculateSerializeBufferSize();
 	btAssert(calculatedBufSize <= i_dataBufferSize);
 
@@ -490,6 +490,22 @@ public:
 		return m_useQuantization;
 	}
 
+	///the quantization bounds and scale, for checking a tree loaded with deSerializeInPlace against its mesh
+	SIMD_FORCE_INLINE const btVector3&	getQuantizationAabbMin() const
+	{
+		return m_bvhAabbMin;
+	}
+
+	SIMD_FORCE_INLINE const btVector3&	getQuantizationAabbMax() const
+	{
+		return m_bvhAabbMax;
+	}
+
+	SIMD_FORCE_INLINE const btVector3&	getQuantization() const
+	{
+		return m_bvhQuantization;
+	}
+
 private:
 	// Special "copy" constructor that allows for in-place deserialization
 	// Prevents btVector3's default constructor from being called, but doesn't inialize much else
@@ -521,7 +521,7 @@ void btConvexConvexAlgorithm ::processCollision (const btCollisionObjectWrapper*
 			if (polyhedronA->getConvexPolyhedron() && polyhedronB->getShapeType()==TRIANGLE_SHAPE_PROXYTYPE)
 			{
 
-				btVertexArray vertices;
+				btClipVertexArray vertices;
 				btTriangleShape* tri = (btTriangleShape*)polyhedronB;
 				vertices.push_back(	body1Wrap->getWorldTransform()*tri->m_vertices1[0]);
 				vertices.push_back(	body1Wrap->getWorldTransform()*tri->m_vertices1[1]);
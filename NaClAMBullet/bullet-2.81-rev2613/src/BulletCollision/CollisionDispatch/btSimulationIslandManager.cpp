@@ -199,6 +199,14 @@ class btPersistentManifoldSortPredicate
 		}
 };
 
+struct btPersistentManifoldSortKey
+{
+	SIMD_FORCE_INLINE int operator() ( const btPersistentManifold* manifold ) const
+	{
+		return getIslandId(manifold);
+	}
+};
+
 
 void btSimulationIslandManager::buildIslands(btDispatcher* dispatcher,btCollisionWorld* collisionWorld)
 {
@@ -377,9 +385,13 @@ void btSimulationIslandManager::buildAndProcessIslands(btDispatcher* dispatcher,
 
 		int numManifolds = int (m_islandmanifold.size());
 
-		//tried a radix sort, but quicksort/heapsort seems still faster
+		//the radix sort computes each island id once and keeps the dispatcher order of manifolds within an island
 		//@todo rewrite island management
-		m_islandmanifold.quickSort(btPersistentManifoldSortPredicate());
+		{
+			BT_PROFILE("sortIslandManifolds");
+			m_islandmanifoldSort.sort(m_islandmanifold, btPersistentManifoldSortKey());
+		}
+		//m_islandmanifold.quickSort(btPersistentManifoldSortPredicate());
 		//m_islandmanifold.heapSort(btPersistentManifoldSortPredicate());
 
 		//now process all active islands (sets of manifolds for now)
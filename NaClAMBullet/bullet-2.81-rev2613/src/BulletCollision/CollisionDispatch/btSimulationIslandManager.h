@@ -19,6 +19,7 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionDispatch/btUnionFind.h"
 #include "btCollisionCreateFunc.h"
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btRadixSort.h"
 #include "btCollisionObject.h"
 
 class btCollisionObject;
@@ -33,6 +34,7 @@ class btSimulationIslandManager
 	btUnionFind m_unionFind;
 
 	btAlignedObjectArray<btPersistentManifold*>  m_islandmanifold;
+	btRadixSort<btPersistentManifold*>	m_islandmanifoldSort;
 	btAlignedObjectArray<btCollisionObject* >  m_islandBodies;
 	
 	bool m_splitIslands;
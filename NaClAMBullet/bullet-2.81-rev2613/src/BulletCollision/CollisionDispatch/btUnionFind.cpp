@@ -14,6 +14,7 @@ subject to the following restrictions:
 */
 
 #include "btUnionFind.h"
+#include "LinearMath/btQuickprof.h"
 
 
 
@@ -59,10 +60,19 @@ class btUnionFindElementSortPredicate
 		}
 };
 
+struct btUnionFindElementSortKey
+{
+	SIMD_FORCE_INLINE int operator() ( const btElement& element ) const
+	{
+		return element.m_id;
+	}
+};
+
 ///this is a special operation, destroying the content of btUnionFind.
 ///it sorts the elements, based on island id, in order to make it easy to iterate over islands
 void	btUnionFind::sortIslands()
 {
+	BT_PROFILE("sortIslands");
 
 	//first store the original body index, and islandId
 	int numElements = m_elements.size();
@@ -77,6 +87,7 @@ void	btUnionFind::sortIslands()
 	
 	 // Sort the vector using predicate and std::sort
 	  //std::sort(m_elements.begin(), m_elements.end(), btUnionFindElementSortPredicate);
-	  m_elements.quickSort(btUnionFindElementSortPredicate());
+	  //m_elements.quickSort(btUnionFindElementSortPredicate());
+	  m_elementSort.sort(m_elements, btUnionFindElementSortKey());
 
 }
@@ -17,6 +17,7 @@ subject to the following restrictions:
 #define BT_UNION_FIND_H
 
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btRadixSort.h"
 
 #define USE_PATH_COMPRESSION 1
 
@@ -36,6 +37,7 @@ class btUnionFind
   {
     private:
 		btAlignedObjectArray<btElement>	m_elements;
+		btRadixSort<btElement>	m_elementSort;
 
     public:
 	  
@@ -18,8 +18,26 @@ subject to the following restrictions:
 
 #include "LinearMath/btQuaternion.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btConvexHullComputer.h"
 
-btConvexHullShape ::btConvexHullShape (const btScalar* points,int numPoints,int stride) : btPolyhedralConvexAabbCachingShape ()
+#if !defined (BT_USE_DOUBLE_PRECISION) && (defined (BT_USE_SSE) || defined (__SSE__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 1))
+#define BT_CONVEX_HULL_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+struct	btConvexHullSupportData
+{
+	///points in blocks of four, stored as xxxx yyyy zzzz (16 byte aligned)
+	btAlignedObjectArray<btScalar>	m_soaPoints;
+	///hull vertices and their neighbours along hull edges, used to hill-climb towards the support vertex
+	btAlignedObjectArray<btVector3>	m_hullVertices;
+	btAlignedObjectArray<int>	m_hullAdjacencyOffsets;
+	btAlignedObjectArray<int>	m_hullAdjacency;
+	int	m_hullStartVertices[6];
+};
+
+btConvexHullShape ::btConvexHullShape (const btScalar* points,int numPoints,int stride) : btPolyhedralConvexAabbCachingShape (),
+m_supportData(0)
 {
 	m_shapeType = CONVEX_HULL_SHAPE_PROXYTYPE;
 	m_unscaledPoints.resize(numPoints);
@@ -37,7 +55,25 @@ btConvexHullShape ::btConvexHullShape (const btScalar* points,int numPoints,int
 
 }
 
+btConvexHullShape::~btConvexHullShape()
+{
+	clearSupportData();
+}
 
+void	btConvexHullShape::clearSupportData()
+{
+	if (m_supportData)
+	{
+		m_supportData->~btConvexHullSupportData();
+		btAlignedFree(m_supportData);
+		m_supportData = 0;
+	}
+}
+
+bool	btConvexHullShape::hasSupportGraph() const
+{
+	return m_supportData && m_supportData->m_hullAdjacency.size() > 0;
+}
 
 void btConvexHullShape::setLocalScaling(const btVector3& scaling)
 {
@@ -48,10 +84,199 @@ void btConvexHullShape::setLocalScaling(const btVector3& scaling)
 void btConvexHullShape::addPoint(const btVector3& point)
 {
 	m_unscaledPoints.push_back(point);
+	clearSupportData();
 	recalcLocalAabb();
 
 }
 
+void	btConvexHullShape::optimizeSupportQueries(int hillClimbingThreshold)
+{
+	int numPoints = m_unscaledPoints.size();
+	clearSupportData();
+	if (numPoints == 0)
+		return;
+
+	void* mem = btAlignedAlloc(sizeof(btConvexHullSupportData),16);
+	m_supportData = new (mem) btConvexHullSupportData;
+	btAlignedObjectArray<btScalar>& soaPoints = m_supportData->m_soaPoints;
+	btAlignedObjectArray<btVector3>& hullVertices = m_supportData->m_hullVertices;
+	btAlignedObjectArray<int>& hullAdjacencyOffsets = m_supportData->m_hullAdjacencyOffsets;
+	btAlignedObjectArray<int>& hullAdjacency = m_supportData->m_hullAdjacency;
+
+	//pad the last block with copies of the last point, so the SIMD loop needs no remainder handling
+	int numBlocks = (numPoints + 3) / 4;
+	soaPoints.resize(numBlocks * 12);
+	for (int i=0;i<numBlocks*4;i++)
+	{
+		const btVector3& pt = m_unscaledPoints[btMin(i, numPoints-1)];
+		btScalar* block = &soaPoints[(i / 4) * 12];
+		block[i & 3] = pt.getX();
+		block[4 + (i & 3)] = pt.getY();
+		block[8 + (i & 3)] = pt.getZ();
+	}
+
+	if (numPoints <= hillClimbingThreshold)
+		return;
+
+	btConvexHullComputer hull;
+	hull.compute(&m_unscaledPoints[0].getX(), sizeof(btVector3), numPoints, btScalar(0.), btScalar(0.));
+	int numVertices = hull.vertices.size();
+	if (numVertices == 0 || hull.edges.size() == 0)
+		return;
+
+	//the hull computer works on quantized coordinates, snap its vertices back onto the input points
+	hullVertices.resize(numVertices);
+	for (int i=0;i<numVertices;i++)
+	{
+		int closest = 0;
+		btScalar closestDist2 = BT_LARGE_FLOAT;
+		for (int j=0;j<numPoints;j++)
+		{
+			btScalar dist2 = m_unscaledPoints[j].distance2(hull.vertices[i]);
+			if (dist2 < closestDist2)
+			{
+				closestDist2 = dist2;
+				closest = j;
+			}
+		}
+		hullVertices[i] = m_unscaledPoints[closest];
+	}
+
+	//compressed adjacency lists, one entry per half edge
+	hullAdjacencyOffsets.resize(numVertices+1,0);
+	for (int i=0;i<hull.edges.size();i++)
+	{
+		hullAdjacencyOffsets[hull.edges[i].getSourceVertex()+1]++;
+	}
+	for (int i=0;i<numVertices;i++)
+	{
+		hullAdjacencyOffsets[i+1] += hullAdjacencyOffsets[i];
+	}
+	btAlignedObjectArray<int> fill;
+	fill.resize(numVertices,0);
+	hullAdjacency.resize(hull.edges.size());
+	for (int i=0;i<hull.edges.size();i++)
+	{
+		int source = hull.edges[i].getSourceVertex();
+		hullAdjacency[hullAdjacencyOffsets[source] + fill[source]++] = hull.edges[i].getTargetVertex();
+	}
+
+	//extreme vertices along the principal axes seed the walk close to the answer
+	for (int axis=0;axis<3;axis++)
+	{
+		int minIndex = 0;
+		int maxIndex = 0;
+		for (int i=1;i<numVertices;i++)
+		{
+			if (hullVertices[i][axis] < hullVertices[minIndex][axis])
+				minIndex = i;
+			if (hullVertices[i][axis] > hullVertices[maxIndex][axis])
+				maxIndex = i;
+		}
+		m_supportData->m_hullStartVertices[axis*2] = minIndex;
+		m_supportData->m_hullStartVertices[axis*2+1] = maxIndex;
+	}
+}
+
+btVector3	btConvexHullShape::unscaledSupportingVertex(const btVector3& vec, btScalar& maxDot) const
+{
+	const btConvexHullSupportData* data = m_supportData;
+	if (data && data->m_hullAdjacency.size())
+	{
+		const btAlignedObjectArray<btVector3>& hullVertices = data->m_hullVertices;
+		const int* hullAdjacencyOffsets = &data->m_hullAdjacencyOffsets[0];
+		const int* hullAdjacency = &data->m_hullAdjacency[0];
+		int current = data->m_hullStartVertices[0];
+		maxDot = vec.dot(hullVertices[current]);
+		for (int i=1;i<6;i++)
+		{
+			btScalar dot = vec.dot(hullVertices[data->m_hullStartVertices[i]]);
+			if (dot > maxDot)
+			{
+				maxDot = dot;
+				current = data->m_hullStartVertices[i];
+			}
+		}
+		//steepest ascent along hull edges, a local maximum on a convex hull is the global one
+		for (;;)
+		{
+			int next = -1;
+			for (int e=hullAdjacencyOffsets[current];e<hullAdjacencyOffsets[current+1];e++)
+			{
+				int neighbour = hullAdjacency[e];
+				btScalar dot = vec.dot(hullVertices[neighbour]);
+				if (dot > maxDot)
+				{
+					maxDot = dot;
+					next = neighbour;
+				}
+			}
+			if (next < 0)
+				break;
+			current = next;
+		}
+		return hullVertices[current];
+	}
+
+	if (data && data->m_soaPoints.size())
+	{
+		int numBlocks = data->m_soaPoints.size() / 12;
+		const btScalar* block = &data->m_soaPoints[0];
+		int index = 0;
+#ifdef BT_CONVEX_HULL_USE_SSE
+		const __m128 dx = _mm_set1_ps(vec.getX());
+		const __m128 dy = _mm_set1_ps(vec.getY());
+		const __m128 dz = _mm_set1_ps(vec.getZ());
+		const __m128 one = _mm_set1_ps(1.f);
+		__m128 best = _mm_set1_ps(-BT_LARGE_FLOAT);
+		__m128 bestBlock = _mm_setzero_ps();
+		__m128 blockIndex = _mm_setzero_ps();
+		for (int b=0;b<numBlocks;b++,block+=12)
+		{
+			__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(block), dx),
+				_mm_mul_ps(_mm_load_ps(block+4), dy)),
+				_mm_mul_ps(_mm_load_ps(block+8), dz));
+			__m128 mask = _mm_cmpgt_ps(dot, best);
+			best = _mm_max_ps(dot, best);
+			bestBlock = _mm_or_ps(_mm_and_ps(mask, blockIndex), _mm_andnot_ps(mask, bestBlock));
+			blockIndex = _mm_add_ps(blockIndex, one);
+		}
+		ATTRIBUTE_ALIGNED16(float bestDots[4]);
+		ATTRIBUTE_ALIGNED16(float bestBlocks[4]);
+		_mm_store_ps(bestDots, best);
+		_mm_store_ps(bestBlocks, bestBlock);
+		maxDot = bestDots[0];
+		index = int(bestBlocks[0]) * 4;
+		for (int lane=1;lane<4;lane++)
+		{
+			if (bestDots[lane] > maxDot)
+			{
+				maxDot = bestDots[lane];
+				index = int(bestBlocks[lane]) * 4 + lane;
+			}
+		}
+#else
+		maxDot = btScalar(-BT_LARGE_FLOAT);
+		for (int b=0;b<numBlocks;b++,block+=12)
+		{
+			for (int lane=0;lane<4;lane++)
+			{
+				btScalar dot = block[lane]*vec.getX() + block[4+lane]*vec.getY() + block[8+lane]*vec.getZ();
+				if (dot > maxDot)
+				{
+					maxDot = dot;
+					index = b*4 + lane;
+				}
+			}
+		}
+#endif
+		return m_unscaledPoints[btMin(index, m_unscaledPoints.size()-1)];
+	}
+
+	int index = (int) vec.maxDot( &m_unscaledPoints[0], m_unscaledPoints.size(), maxDot); // FIXME: may violate encapsulation of m_unscaledPoints
+	return m_unscaledPoints[index];
+}
+
 btVector3	btConvexHullShape::localGetSupportingVertexWithoutMargin(const btVector3& vec)const
 {
 	btVector3 supVec(btScalar(0.),btScalar(0.),btScalar(0.));
@@ -61,8 +286,7 @@ btVector3	btConvexHullShape::localGetSupportingVertexWithoutMargin(const btVecto
     if( 0 < m_unscaledPoints.size() )
     {
         btVector3 scaled = vec * m_localScaling;
-        int index = (int) scaled.maxDot( &m_unscaledPoints[0], m_unscaledPoints.size(), maxDot); // FIXME: may violate encapsulation of m_unscaledPoints
-        return m_unscaledPoints[index] * m_localScaling;
+        return unscaledSupportingVertex(scaled, maxDot) * m_localScaling;
     }
 
     return supVec;
@@ -84,8 +308,7 @@ void	btConvexHullShape::batchedUnitVectorGetSupportingVertexWithoutMargin(const
         btVector3 vec = vectors[j] * m_localScaling;        // dot(a*b,c) = dot(a,b*c)
         if( 0 <  m_unscaledPoints.size() )
         {
-            int i = (int) vec.maxDot( &m_unscaledPoints[0], m_unscaledPoints.size(), newDot);
-            supportVerticesOut[j] = getScaledPoint(i);
+            supportVerticesOut[j] = unscaledSupportingVertex(vec, newDot) * m_localScaling;
             supportVerticesOut[j][3] = newDot;        
         }
         else
@@ -20,6 +20,8 @@ subject to the following restrictions:
 #include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h" // for the types
 #include "LinearMath/btAlignedObjectArray.h"
 
+struct	btConvexHullSupportData;
+
 
 ///The btConvexHullShape implements an implicit convex hull of an array of vertices.
 ///Bullet provides a general and fast collision detector for convex shapes based on GJK and EPA using localGetSupportingVertex.
@@ -27,6 +29,18 @@ ATTRIBUTE_ALIGNED16(class) btConvexHullShape : public btPolyhedralConvexAabbCach
 {
 	btAlignedObjectArray<btVector3>	m_unscaledPoints;
 
+	///optional support query acceleration built by optimizeSupportQueries, owned by the shape.
+	///It is kept out of line so the shape still fits the fixed size copies BulletMultiThreaded makes of it (MAX_SHAPE_SIZE).
+	btConvexHullSupportData*	m_supportData;
+
+	btVector3	unscaledSupportingVertex(const btVector3& vec, btScalar& maxDot) const;
+
+	void	clearSupportData();
+
+	//the shape owns m_supportData
+	btConvexHullShape(const btConvexHullShape&);
+	btConvexHullShape&	operator=(const btConvexHullShape&);
+
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
 
@@ -36,8 +50,18 @@ public:
 	///btConvexHullShape make an internal copy of the points.
 	btConvexHullShape(const btScalar* points=0,int numPoints=0, int stride=sizeof(btVector3));
 
+	virtual ~btConvexHullShape();
+
 	void addPoint(const btVector3& point);
 
+	///optimizeSupportQueries builds a SoA copy of the points that is scanned with SIMD instructions.
+	///For hulls with more than hillClimbingThreshold points it also builds the vertex adjacency graph of the hull,
+	///so that support queries walk the hull instead of testing every point, roughly O(sqrt(n)) instead of O(n).
+	///Call it again after modifying the points; addPoint discards the acceleration data.
+	void	optimizeSupportQueries(int hillClimbingThreshold = 64);
+
+	bool	hasSupportGraph() const;
+
 	
 	btVector3* getUnscaledPoints()
 	{
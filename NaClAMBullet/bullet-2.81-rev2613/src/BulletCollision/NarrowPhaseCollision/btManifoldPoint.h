@@ -153,4 +153,6 @@ class btManifoldPoint
 
 	};
 
+BT_DECLARE_TRIVIALLY_RELOCATABLE(btManifoldPoint)
+
 #endif //BT_MANIFOLD_CONTACT_POINT_H
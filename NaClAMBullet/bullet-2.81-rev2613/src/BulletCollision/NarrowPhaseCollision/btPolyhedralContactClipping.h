@@ -28,6 +28,8 @@ subject to the following restrictions:
 class btConvexPolyhedron;
 
 typedef btAlignedObjectArray<btVector3> btVertexArray;
+///Per call clipping polygons, a box face clipped by a box stays within the inline storage
+typedef btSmallAlignedObjectArray<btVector3,16> btClipVertexArray;
 
 // Clips a face to the back of a plane
 struct btPolyhedralContactClipping
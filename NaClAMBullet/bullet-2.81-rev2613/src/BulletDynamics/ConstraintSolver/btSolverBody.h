@@ -288,6 +288,8 @@ ATTRIBUTE_ALIGNED64 (struct)	btSolverBody
 
 };
 
+BT_DECLARE_TRIVIALLY_RELOCATABLE(btSolverBody)
+
 #endif //BT_SOLVER_BODY_H
 
 
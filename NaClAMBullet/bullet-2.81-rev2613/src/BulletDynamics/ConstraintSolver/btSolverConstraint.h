@@ -70,6 +70,8 @@ ATTRIBUTE_ALIGNED16 (struct)	btSolverConstraint
 	};
 };
 
+BT_DECLARE_TRIVIALLY_RELOCATABLE(btSolverConstraint)
+
 typedef btAlignedObjectArray<btSolverConstraint>	btConstraintArray;
 
 
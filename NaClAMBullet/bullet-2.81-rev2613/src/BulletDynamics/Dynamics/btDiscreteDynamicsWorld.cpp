@@ -80,6 +80,14 @@ class btSortConstraintOnIslandPredicate
 		}
 };
 
+struct btSortConstraintOnIslandKey
+{
+	SIMD_FORCE_INLINE int operator() ( const btTypedConstraint* constraint ) const
+	{
+		return btGetConstraintIslandId(constraint);
+	}
+};
+
 struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCallback
 {
 	btContactSolverInfo*	m_solverInfo;
@@ -210,6 +218,7 @@ m_gravity(0,-10,0),
 m_localTime(0),
 m_synchronizeAllMotionStates(false),
 m_applySpeculativeContactRestitution(false),
+m_batchedIntegration(false),
 m_profileTimings(0)
 
 {
@@ -712,7 +721,10 @@ void	btDiscreteDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 		
 	
 
-	m_sortedConstraints.quickSort(btSortConstraintOnIslandPredicate());
+	{
+		BT_PROFILE("sortConstraints");
+		m_constraintSort.sort(m_sortedConstraints, btSortConstraintOnIslandKey());
+	}
 	
 	btTypedConstraint** constraintsPtr = getNumConstraints() ? &m_sortedConstraints[0] : 0;
 	
@@ -973,10 +985,162 @@ void	btDiscreteDynamicsWorld::createPredictiveContacts(btScalar timeStep)
 		}
 	}
 }
+
+#if defined (BT_USE_SSE_IN_API) && defined (BT_USE_SSE)
+static SIMD_FORCE_INLINE __m128 btSelect4(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+///btTransformUtil::integrateTransform for up to four bodies at once. Their transforms and velocities are
+///transposed so that each register holds one component of all four bodies. The half angle of the rotation
+///is at most ANGULAR_MOTION_THRESHOLD/2 = pi/8, where the sine and cosine polynomials are exact to float precision.
+static void integrateTransforms4(btRigidBody* const* bodies, btTransform* predictedTransforms, int count, btScalar timeStep)
+{
+	const btRigidBody* b0 = bodies[0];
+	const btRigidBody* b1 = bodies[btMin(1, count-1)];
+	const btRigidBody* b2 = bodies[btMin(2, count-1)];
+	const btRigidBody* b3 = bodies[btMin(3, count-1)];
+	const btTransform& t0 = b0->getWorldTransform();
+	const btTransform& t1 = b1->getWorldTransform();
+	const btTransform& t2 = b2->getWorldTransform();
+	const btTransform& t3 = b3->getWorldTransform();
+
+	__m128 m00 = t0.getBasis()[0].get128(), m01 = t1.getBasis()[0].get128(), m02 = t2.getBasis()[0].get128(), unused = t3.getBasis()[0].get128();
+	_MM_TRANSPOSE4_PS(m00, m01, m02, unused);
+	__m128 m10 = t0.getBasis()[1].get128(), m11 = t1.getBasis()[1].get128(), m12 = t2.getBasis()[1].get128(); unused = t3.getBasis()[1].get128();
+	_MM_TRANSPOSE4_PS(m10, m11, m12, unused);
+	__m128 m20 = t0.getBasis()[2].get128(), m21 = t1.getBasis()[2].get128(), m22 = t2.getBasis()[2].get128(); unused = t3.getBasis()[2].get128();
+	_MM_TRANSPOSE4_PS(m20, m21, m22, unused);
+	__m128 px = t0.getOrigin().get128(), py = t1.getOrigin().get128(), pz = t2.getOrigin().get128(); unused = t3.getOrigin().get128();
+	_MM_TRANSPOSE4_PS(px, py, pz, unused);
+	__m128 vx = b0->getLinearVelocity().get128(), vy = b1->getLinearVelocity().get128(), vz = b2->getLinearVelocity().get128(); unused = b3->getLinearVelocity().get128();
+	_MM_TRANSPOSE4_PS(vx, vy, vz, unused);
+	__m128 wx = b0->getAngularVelocity().get128(), wy = b1->getAngularVelocity().get128(), wz = b2->getAngularVelocity().get128(); unused = b3->getAngularVelocity().get128();
+	_MM_TRANSPOSE4_PS(wx, wy, wz, unused);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 dt = _mm_set1_ps(timeStep);
+
+	//position
+	px = _mm_add_ps(px, _mm_mul_ps(vx, dt));
+	py = _mm_add_ps(py, _mm_mul_ps(vy, dt));
+	pz = _mm_add_ps(pz, _mm_mul_ps(vz, dt));
+
+	//orientation, picking the same case of btMatrix3x3::getRotation in each lane
+	__m128 useW = _mm_cmpgt_ps(_mm_add_ps(_mm_add_ps(m00, m11), m22), zero);
+	__m128 lt01 = _mm_cmplt_ps(m00, m11);
+	__m128 lt12 = _mm_cmplt_ps(m11, m22);
+	__m128 lt02 = _mm_cmplt_ps(m00, m22);
+	__m128 useY = _mm_andnot_ps(lt12, lt01);
+	__m128 useX = _mm_andnot_ps(_mm_or_ps(lt01, lt02), _mm_cmpeq_ps(zero, zero));
+	__m128 diag = btSelect4(useW, _mm_add_ps(_mm_add_ps(m00, m11), m22),
+		btSelect4(useX, _mm_sub_ps(_mm_sub_ps(m00, m11), m22),
+		btSelect4(useY, _mm_sub_ps(_mm_sub_ps(m11, m22), m00), _mm_sub_ps(_mm_sub_ps(m22, m00), m11))));
+	diag = _mm_add_ps(diag, one);
+	__m128 d21 = _mm_sub_ps(m21, m12), d02 = _mm_sub_ps(m02, m20), d10 = _mm_sub_ps(m10, m01);
+	__m128 s01 = _mm_add_ps(m01, m10), s02 = _mm_add_ps(m02, m20), s12 = _mm_add_ps(m12, m21);
+	__m128 scale = _mm_div_ps(half, _mm_sqrt_ps(diag));
+	__m128 qx = _mm_mul_ps(btSelect4(useW, d21, btSelect4(useX, diag, btSelect4(useY, s01, s02))), scale);
+	__m128 qy = _mm_mul_ps(btSelect4(useW, d02, btSelect4(useX, s01, btSelect4(useY, diag, s12))), scale);
+	__m128 qz = _mm_mul_ps(btSelect4(useW, d10, btSelect4(useX, s02, btSelect4(useY, s12, diag))), scale);
+	__m128 qw = _mm_mul_ps(btSelect4(useW, diag, btSelect4(useX, d21, btSelect4(useY, d02, d10))), scale);
+
+	//exponential map
+	__m128 fAngle = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(wx,wx), _mm_mul_ps(wy,wy)), _mm_mul_ps(wz,wz)));
+	fAngle = _mm_min_ps(fAngle, _mm_set1_ps(ANGULAR_MOTION_THRESHOLD / timeStep));
+	__m128 h = _mm_mul_ps(_mm_mul_ps(half, fAngle), dt);
+	__m128 h2 = _mm_mul_ps(h, h);
+	__m128 sinH = _mm_sub_ps(_mm_set1_ps(1.f/120.f), _mm_mul_ps(h2, _mm_set1_ps(1.f/5040.f)));
+	sinH = _mm_sub_ps(_mm_set1_ps(1.f/6.f), _mm_mul_ps(h2, sinH));
+	sinH = _mm_mul_ps(h, _mm_sub_ps(one, _mm_mul_ps(h2, sinH)));
+	__m128 cosH = _mm_sub_ps(_mm_set1_ps(1.f/720.f), _mm_mul_ps(h2, _mm_set1_ps(1.f/40320.f)));
+	cosH = _mm_sub_ps(_mm_set1_ps(1.f/24.f), _mm_mul_ps(h2, cosH));
+	cosH = _mm_sub_ps(half, _mm_mul_ps(h2, cosH));
+	cosH = _mm_sub_ps(one, _mm_mul_ps(h2, cosH));
+	//use Taylor's expansions of sync function for small angles
+	const __m128 smallAngle = _mm_set1_ps(0.001f);
+	__m128 sincSmall = _mm_sub_ps(_mm_set1_ps(0.5f*timeStep), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps((timeStep*timeStep*timeStep)*btScalar(0.020833333333)), fAngle), fAngle));
+	__m128 sincLarge = _mm_div_ps(sinH, _mm_max_ps(fAngle, smallAngle));
+	__m128 sinc = btSelect4(_mm_cmplt_ps(fAngle, smallAngle), sincSmall, sincLarge);
+	__m128 ax = _mm_mul_ps(wx, sinc), ay = _mm_mul_ps(wy, sinc), az = _mm_mul_ps(wz, sinc);
+
+	//dorn * orn0
+	__m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cosH,qx), _mm_mul_ps(ax,qw)), _mm_mul_ps(ay,qz)), _mm_mul_ps(az,qy));
+	__m128 y = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cosH,qy), _mm_mul_ps(ay,qw)), _mm_mul_ps(az,qx)), _mm_mul_ps(ax,qz));
+	__m128 z = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cosH,qz), _mm_mul_ps(az,qw)), _mm_mul_ps(ax,qy)), _mm_mul_ps(ay,qx));
+	__m128 w = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(cosH,qw), _mm_mul_ps(ax,qx)), _mm_mul_ps(ay,qy)), _mm_mul_ps(az,qz));
+	__m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x,x), _mm_mul_ps(y,y)), _mm_mul_ps(z,z)), _mm_mul_ps(w,w))));
+	x = _mm_mul_ps(x, invLength);
+	y = _mm_mul_ps(y, invLength);
+	z = _mm_mul_ps(z, invLength);
+	w = _mm_mul_ps(w, invLength);
+
+	//back to a basis, as btMatrix3x3::setRotation
+	__m128 s = _mm_div_ps(_mm_set1_ps(2.f), _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x,x), _mm_mul_ps(y,y)), _mm_mul_ps(z,z)), _mm_mul_ps(w,w)));
+	__m128 xs = _mm_mul_ps(x, s), ys = _mm_mul_ps(y, s), zs = _mm_mul_ps(z, s);
+	__m128 wxs = _mm_mul_ps(w, xs), wys = _mm_mul_ps(w, ys), wzs = _mm_mul_ps(w, zs);
+	__m128 xxs = _mm_mul_ps(x, xs), xys = _mm_mul_ps(x, ys), xzs = _mm_mul_ps(x, zs);
+	__m128 yys = _mm_mul_ps(y, ys), yzs = _mm_mul_ps(y, zs), zzs = _mm_mul_ps(z, zs);
+	m00 = _mm_sub_ps(one, _mm_add_ps(yys, zzs)); m01 = _mm_sub_ps(xys, wzs); m02 = _mm_add_ps(xzs, wys);
+	m10 = _mm_add_ps(xys, wzs); m11 = _mm_sub_ps(one, _mm_add_ps(xxs, zzs)); m12 = _mm_sub_ps(yzs, wxs);
+	m20 = _mm_sub_ps(xzs, wys); m21 = _mm_add_ps(yzs, wxs); m22 = _mm_sub_ps(one, _mm_add_ps(xxs, yys));
+
+	__m128 r0[4] = { m00, m01, m02, zero };
+	__m128 r1[4] = { m10, m11, m12, zero };
+	__m128 r2[4] = { m20, m21, m22, zero };
+	__m128 o[4] = { px, py, pz, zero };
+	_MM_TRANSPOSE4_PS(r0[0], r0[1], r0[2], r0[3]);
+	_MM_TRANSPOSE4_PS(r1[0], r1[1], r1[2], r1[3]);
+	_MM_TRANSPOSE4_PS(r2[0], r2[1], r2[2], r2[3]);
+	_MM_TRANSPOSE4_PS(o[0], o[1], o[2], o[3]);
+	for (int k=0;k<count;k++)
+	{
+		btTransform& predicted = predictedTransforms[k];
+		predicted.getBasis()[0].set128(r0[k]);
+		predicted.getBasis()[1].set128(r1[k]);
+		predicted.getBasis()[2].set128(r2[k]);
+		predicted.getOrigin().set128(o[k]);
+	}
+}
+#endif //BT_USE_SSE_IN_API && BT_USE_SSE
+
+void	btDiscreteDynamicsWorld::predictIntegratedTransformsBatched(btScalar timeStep)
+{
+	BT_PROFILE("batched transform integration");
+	int numBodies = m_integrationBodies.size();
+	m_integratedTransforms.resize(numBodies);
+	int i = 0;
+#if defined (BT_USE_SSE_IN_API) && defined (BT_USE_SSE)
+	for (;i<numBodies;i+=4)
+	{
+		integrateTransforms4(&m_integrationBodies[i], &m_integratedTransforms[i], btMin(4, numBodies-i), timeStep);
+	}
+#endif
+	for (;i<numBodies;i++)
+	{
+		m_integrationBodies[i]->predictIntegratedTransform(timeStep, m_integratedTransforms[i]);
+	}
+}
+
 void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 {
 	BT_PROFILE("integrateTransforms");
 	btTransform predictedTrans;
+	int batched = 0;
+	if (m_batchedIntegration)
+	{
+		m_integrationBodies.resize(0);
+		for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+		{
+			btRigidBody* body = m_nonStaticRigidBodies[i];
+			if (body->isActive() && (!body->isStaticOrKinematicObject()))
+				m_integrationBodies.push_back(body);
+		}
+		predictIntegratedTransformsBatched(timeStep);
+	}
 	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
 	{
 		btRigidBody* body = m_nonStaticRigidBodies[i];
@@ -985,7 +1149,10 @@ void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 		if (body->isActive() && (!body->isStaticOrKinematicObject()))
 		{
 
-			body->predictIntegratedTransform(timeStep, predictedTrans);
+			if (m_batchedIntegration)
+				predictedTrans = m_integratedTransforms[batched++];
+			else
+				body->predictIntegratedTransform(timeStep, predictedTrans);
 			
 			btScalar squareMotion = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
 
@@ -1124,6 +1291,7 @@ void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 void	btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
 {
 	BT_PROFILE("predictUnconstraintMotion");
+	m_integrationBodies.resize(0);
 	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
 	{
 		btRigidBody* body = m_nonStaticRigidBodies[i];
@@ -1134,9 +1302,18 @@ void	btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
 			//damping
 			body->applyDamping(timeStep);
 
-			body->predictIntegratedTransform(timeStep,body->getInterpolationWorldTransform());
+			if (m_batchedIntegration)
+				m_integrationBodies.push_back(body);
+			else
+				body->predictIntegratedTransform(timeStep,body->getInterpolationWorldTransform());
 		}
 	}
+	if (m_batchedIntegration)
+	{
+		predictIntegratedTransformsBatched(timeStep);
+		for (int i=0;i<m_integrationBodies.size();i++)
+			m_integrationBodies[i]->getInterpolationWorldTransform() = m_integratedTransforms[i];
+	}
 }
 
 
@@ -30,6 +30,7 @@ class btIDebugDraw;
 struct InplaceSolverIslandCallback;
 
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btRadixSort.h"
 
 
 ///btDiscreteDynamicsWorld provides discrete rigid body simulation
@@ -39,6 +40,7 @@ ATTRIBUTE_ALIGNED16(class) btDiscreteDynamicsWorld : public btDynamicsWorld
 protected:
 	
     btAlignedObjectArray<btTypedConstraint*>	m_sortedConstraints;
+	btRadixSort<btTypedConstraint*>	m_constraintSort;
 	InplaceSolverIslandCallback* 	m_solverIslandCallback;
 
 	btConstraintSolver*	m_constraintSolver;
@@ -59,6 +61,11 @@ protected:
 	bool	m_ownsConstraintSolver;
 	bool	m_synchronizeAllMotionStates;
 	bool	m_applySpeculativeContactRestitution;
+	bool	m_batchedIntegration;
+
+	///bodies and results of the batched transform integration
+	btAlignedObjectArray<btRigidBody*>	m_integrationBodies;
+	btAlignedObjectArray<btTransform>	m_integratedTransforms;
 
 	btAlignedObjectArray<btActionInterface*>	m_actions;
 	
@@ -69,6 +76,9 @@ protected:
 	virtual void	predictUnconstraintMotion(btScalar timeStep);
 	
 	virtual void	integrateTransforms(btScalar timeStep);
+
+	///predicts the transforms of all bodies in m_integrationBodies into m_integratedTransforms, four bodies at a time with SSE
+	void	predictIntegratedTransformsBatched(btScalar timeStep);
 		
 	virtual void	calculateSimulationIslands();
 
@@ -213,6 +223,18 @@ public:
 		return m_applySpeculativeContactRestitution;
 	}
 
+	///integrate the transforms of dynamic bodies in batches instead of one body at a time.
+	///The result differs from btTransformUtil::integrateTransform by a few ulp, since the rotation uses polynomial sine and cosine
+	void setBatchedIntegration(bool enable)
+	{
+		m_batchedIntegration = enable;
+	}
+
+	bool getBatchedIntegration() const
+	{
+		return m_batchedIntegration;
+	}
+
 	///Preliminary serialization test for Bullet 2.76. Loading those files requires a separate parser (see Bullet/Demos/SerializeDemo)
 	virtual	void	serialize(btSerializer* serializer);
 
@@ -55,6 +55,7 @@ void	btRigidBody::setupRigidBody(const btRigidBody::btRigidBodyConstructionInfo&
 
 	m_linearSleepingThreshold = constructionInfo.m_linearSleepingThreshold;
 	m_angularSleepingThreshold = constructionInfo.m_angularSleepingThreshold;
+	m_deactivationTimeThreshold = btScalar(-1.);
 	m_optionalMotionState = constructionInfo.m_motionState;
 	m_contactSolverType = 0;
 	m_frictionSolverType = 0;
@@ -83,6 +83,8 @@ class btRigidBody  : public btCollisionObject
 
 	btScalar		m_linearSleepingThreshold;
 	btScalar		m_angularSleepingThreshold;
+	///seconds below the sleeping thresholds before the body may sleep, negative uses gDeactivationTime
+	btScalar		m_deactivationTimeThreshold;
 
 	//m_optionalMotionState allows to automatic synchronize the world transform for active objects
 	btMotionState*	m_optionalMotionState;
@@ -304,6 +306,17 @@ public:
 		m_angularSleepingThreshold = angular;
 	}
 
+	///Overrides gDeactivationTime for this body, so worlds stepped on different threads can use different values. Negative restores gDeactivationTime.
+	void	setDeactivationTimeThreshold(btScalar time)
+	{
+		m_deactivationTimeThreshold = time;
+	}
+
+	btScalar	getDeactivationTimeThreshold() const
+	{
+		return m_deactivationTimeThreshold < btScalar(0.) ? gDeactivationTime : m_deactivationTimeThreshold;
+	}
+
 	void	applyTorque(const btVector3& torque)
 	{
 		m_totalTorque += torque*m_angularFactor;
@@ -433,14 +446,16 @@ public:
 		if (getActivationState() == DISABLE_DEACTIVATION)
 			return false;
 
+		btScalar deactivationTimeThreshold = getDeactivationTimeThreshold();
+
 		//disable deactivation
-		if (gDisableDeactivation || (gDeactivationTime == btScalar(0.)))
+		if (gDisableDeactivation || (deactivationTimeThreshold == btScalar(0.)))
 			return false;
 
 		if ( (getActivationState() == ISLAND_SLEEPING) || (getActivationState() == WANTS_DEACTIVATION))
 			return true;
 
-		if (m_deactivationTime> gDeactivationTime)
+		if (m_deactivationTime> deactivationTimeThreshold)
 		{
 			return true;
 		}
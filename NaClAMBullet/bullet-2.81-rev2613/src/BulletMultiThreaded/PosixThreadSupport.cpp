@@ -47,8 +47,6 @@ PosixThreadSupport::~PosixThreadSupport()
 #define NAMED_SEMAPHORES
 #endif
 
-// this semaphore will signal, if and how many threads are finished with their work
-static sem_t* mainSemaphore=0;
 
 static sem_t* createSem(const char* baseName)
 {
@@ -103,12 +101,12 @@ static void *threadFunction(void *argument)
 			btAssert(status->m_status);
 			status->m_userThreadFunc(userPtr,status->m_lsMemory);
 			status->m_status = 2;
-			checkPThreadFunction(sem_post(mainSemaphore));
+			checkPThreadFunction(sem_post(status->mainSemaphore));
 	                status->threadUsed++;
 		} else {
 			//exit Thread
 			status->m_status = 3;
-			checkPThreadFunction(sem_post(mainSemaphore));
+			checkPThreadFunction(sem_post(status->mainSemaphore));
 			printf("Thread with taskId %i exiting\n",status->m_taskId);
 			break;
 		}
@@ -168,7 +166,7 @@ void PosixThreadSupport::waitForResponse(unsigned int *puiArgument0, unsigned in
 	btAssert(m_activeSpuStatus.size());
 
         // wait for any of the threads to finish
-	checkPThreadFunction(sem_wait(mainSemaphore));
+	checkPThreadFunction(sem_wait(m_mainSemaphore));
         
 	// get at least one thread which has finished
         size_t last = -1;
@@ -199,8 +197,8 @@ void PosixThreadSupport::startThreads(ThreadConstructionInfo& threadConstruction
         printf("%s creating %i threads.\n", __FUNCTION__, threadConstructionInfo.m_numThreads);
 	m_activeSpuStatus.resize(threadConstructionInfo.m_numThreads);
         
-	mainSemaphore = createSem("main");                
-	//checkPThreadFunction(sem_wait(mainSemaphore));
+	m_mainSemaphore = createSem("main");                
+	//checkPThreadFunction(sem_wait(m_mainSemaphore));
    
 	for (int i=0;i < threadConstructionInfo.m_numThreads;i++)
 	{
@@ -209,6 +207,7 @@ void PosixThreadSupport::startThreads(ThreadConstructionInfo& threadConstruction
 		btSpuStatus&	spuStatus = m_activeSpuStatus[i];
 
 		spuStatus.startSemaphore = createSem("threadLocal");                
+		spuStatus.mainSemaphore = m_mainSemaphore;
                 
                 checkPThreadFunction(pthread_create(&spuStatus.thread, NULL, &threadFunction, (void*)&spuStatus));
 
@@ -242,7 +241,7 @@ void PosixThreadSupport::stopSPU()
 
 	spuStatus.m_userPtr = 0;       
  	checkPThreadFunction(sem_post(spuStatus.startSemaphore));
-	checkPThreadFunction(sem_wait(mainSemaphore));
+	checkPThreadFunction(sem_wait(m_mainSemaphore));
 
 	printf("destroy semaphore\n"); 
             destroySem(spuStatus.startSemaphore);
@@ -250,9 +249,14 @@ void PosixThreadSupport::stopSPU()
 		checkPThreadFunction(pthread_join(spuStatus.thread,0));
 
         }
-	printf("destroy main semaphore\n");
-        destroySem(mainSemaphore);
-	printf("main semaphore destroyed\n");
+	//stopSPU is called by SpuCollisionTaskProcess and again by the destructor
+	if (m_mainSemaphore)
+	{
+		printf("destroy main semaphore\n");
+		destroySem(m_mainSemaphore);
+		m_mainSemaphore = 0;
+		printf("main semaphore destroyed\n");
+	}
 	m_activeSpuStatus.clear();
 }
 
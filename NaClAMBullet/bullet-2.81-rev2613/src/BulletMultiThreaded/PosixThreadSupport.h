@@ -61,12 +61,15 @@ public:
 
                 pthread_t thread;
                 sem_t* startSemaphore;
+                sem_t* mainSemaphore; //owned by the PosixThreadSupport
 
         unsigned long threadUsed;
 	};
 private:
 
 	btAlignedObjectArray<btSpuStatus>	m_activeSpuStatus;
+	///signals if and how many of this instance's threads are finished with their work
+	sem_t*	m_mainSemaphore;
 public:
 	///Setup and initialize SPU/CELL/Libspe2
 
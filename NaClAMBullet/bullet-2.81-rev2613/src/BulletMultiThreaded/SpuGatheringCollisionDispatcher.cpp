@@ -33,7 +33,9 @@ SpuGatheringCollisionDispatcher::SpuGatheringCollisionDispatcher(class	btThreadS
 :btCollisionDispatcher(collisionConfiguration),
 m_spuCollisionTaskProcess(0),
 m_threadInterface(threadInterface),
-m_maxNumOutstandingTasks(maxNumOutstandingTasks)
+m_maxNumOutstandingTasks(maxNumOutstandingTasks),
+m_numBatchedPairs(0),
+m_numFallbackPairs(0)
 {
 	
 }
@@ -73,6 +75,25 @@ bool	SpuGatheringCollisionDispatcher::supportsDispatchPairOnSpu(int proxyType0,i
 
 
 
+///the SPU copies the points of a hull, also of a compound child, into a buffer of MAX_NUM_SPU_CONVEX_POINTS
+static bool	spuFitsConvexPoints(const btCollisionShape* shape)
+{
+	if (shape->getShapeType() == CONVEX_HULL_SHAPE_PROXYTYPE)
+	{
+		return ((const btConvexHullShape*)shape)->getNumPoints() <= MAX_NUM_SPU_CONVEX_POINTS;
+	}
+	if (shape->getShapeType() == COMPOUND_SHAPE_PROXYTYPE)
+	{
+		const btCompoundShape* compound = (const btCompoundShape*)shape;
+		for (int i=0;i<compound->getNumChildShapes();i++)
+		{
+			if (!spuFitsConvexPoints(compound->getChildShape(i)))
+				return false;
+		}
+	}
+	return true;
+}
+
 SpuGatheringCollisionDispatcher::~SpuGatheringCollisionDispatcher()
 {
 	if (m_spuCollisionTaskProcess)
@@ -153,6 +174,11 @@ public:
 						}
 					}
 
+					if (!spuFitsConvexPoints(colObj0->getCollisionShape()) || !spuFitsConvexPoints(colObj1->getCollisionShape()))
+					{
+						supportsSpuDispatch = false;
+					}
+
 					if (supportsSpuDispatch)
 					{
 
@@ -235,8 +261,13 @@ void	SpuGatheringCollisionDispatcher::dispatchAllCollisionPairs(btOverlappingPai
 				for (i=0;i<numTotalPairs;i++)
 				{
 					btBroadphasePair& collisionPair = pairPtr[i];
+					if (collisionPair.m_internalTmpValue == 2)
+					{
+						m_numBatchedPairs++;
+					}
 					if (collisionPair.m_internalTmpValue == 3)
 					{
+						m_numFallbackPairs++;
 						if (collisionPair.m_algorithm)
 						{
 							btCollisionObject* colObj0 = (btCollisionObject*)collisionPair.m_pProxy0->m_clientObject;
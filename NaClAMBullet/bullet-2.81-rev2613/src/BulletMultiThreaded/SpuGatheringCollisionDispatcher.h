@@ -45,6 +45,10 @@ protected:
 	class	btThreadSupportInterface*	m_threadInterface;
 
 	unsigned int	m_maxNumOutstandingTasks;
+
+	int		m_numBatchedPairs;
+
+	int		m_numFallbackPairs;
 	
 
 public:
@@ -61,6 +65,24 @@ public:
 
 	bool	supportsDispatchPairOnSpu(int proxyType0,int proxyType1);
 
+	///number of pairs handed to the collision tasks since the last resetNumBatchedPairs, PPU fallback pairs are not counted
+	int	getNumBatchedPairs() const
+	{
+		return m_numBatchedPairs;
+	}
+
+	///number of pairs collided on the calling thread since the last resetNumBatchedPairs, because a shape is not supported on SPU
+	int	getNumFallbackPairs() const
+	{
+		return m_numFallbackPairs;
+	}
+
+	void	resetNumBatchedPairs()
+	{
+		m_numBatchedPairs = 0;
+		m_numFallbackPairs = 0;
+	}
+
 	virtual void	dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher) ;
 
 };
@@ -147,6 +147,15 @@ void dmaBvhSubTreeNodes (btQuantizedBvhNode* nodes, const btBvhSubtreeInfo& subt
 	cellDmaGet(nodes, reinterpret_cast<ppu_address_t>(&nodeArray[subtree.m_rootNodeIndex]) , subtree.m_subtreeSize* sizeof(btQuantizedBvhNode), DMA_TAG(2), 0, 0);
 }
 
+SPU_ASSERT_SHAPE_SIZE(btCylinderShape);
+SPU_ASSERT_SHAPE_SIZE(btBoxShape);
+SPU_ASSERT_SHAPE_SIZE(btSphereShape);
+SPU_ASSERT_SHAPE_SIZE(btBvhTriangleMeshShape);
+SPU_ASSERT_SHAPE_SIZE(btCapsuleShape);
+SPU_ASSERT_SHAPE_SIZE(btConvexHullShape);
+SPU_ASSERT_SHAPE_SIZE(btCompoundShape);
+SPU_ASSERT_SHAPE_SIZE(btStaticPlaneShape);
+
 ///getShapeTypeSize could easily be optimized, but it is not likely a bottleneck
 int		getShapeTypeSize(int shapeType)
 {
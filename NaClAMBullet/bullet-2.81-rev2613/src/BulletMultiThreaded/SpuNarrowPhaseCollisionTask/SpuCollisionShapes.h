@@ -35,7 +35,10 @@ subject to the following restrictions:
 
 #define MAX_NUM_SPU_CONVEX_POINTS 128 //@fallback to PPU if a btConvexHullShape has more than MAX_NUM_SPU_CONVEX_POINTS points
 #define MAX_SPU_COMPOUND_SUBSHAPES 16 //@fallback on PPU if compound has more than MAX_SPU_COMPOUND_SUBSHAPES child shapes
-#define MAX_SHAPE_SIZE 256 //@todo: assert on this
+#define MAX_SHAPE_SIZE 256 //checked for every supported shape type with SPU_ASSERT_SHAPE_SIZE
+
+///compile time check that a shape type fits the MAX_SHAPE_SIZE copies made by dmaCollisionShape
+#define SPU_ASSERT_SHAPE_SIZE(shapeClass) typedef char shapeClass##_exceeds_MAX_SHAPE_SIZE[(sizeof(shapeClass) <= MAX_SHAPE_SIZE) ? 1 : -1]
 
 ATTRIBUTE_ALIGNED16(struct)	SpuConvexPolyhedronVertexData
 {
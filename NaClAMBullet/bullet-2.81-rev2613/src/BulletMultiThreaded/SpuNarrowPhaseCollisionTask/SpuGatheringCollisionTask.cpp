@@ -193,13 +193,24 @@ void* createCollisionLocalStoreMemory()
 void deleteCollisionLocalStoreMemory()
 {
 }
+void deleteCollisionLocalStoreMemory(void* localStore)
+{
+}
 #else
 
 btAlignedObjectArray<CollisionTask_LocalStoreMemory*> sLocalStorePointers;
 
+///The local store holds 16 byte aligned members, plain new only guarantees malloc alignment
+static void destroyCollisionLocalStore(CollisionTask_LocalStoreMemory* localStore)
+{
+    localStore->~CollisionTask_LocalStoreMemory();
+    btAlignedFree(localStore);
+}
+
 void* createCollisionLocalStoreMemory()
 {
-    CollisionTask_LocalStoreMemory* localStore = new CollisionTask_LocalStoreMemory;
+    void* mem = btAlignedAlloc(sizeof(CollisionTask_LocalStoreMemory),16);
+    CollisionTask_LocalStoreMemory* localStore = new (mem) CollisionTask_LocalStoreMemory;
     sLocalStorePointers.push_back(localStore);
     return localStore;
 }
@@ -208,11 +219,23 @@ void deleteCollisionLocalStoreMemory()
 {
     for (int i=0;i<sLocalStorePointers.size();i++)
     {
-        delete sLocalStorePointers[i];
+        destroyCollisionLocalStore(sLocalStorePointers[i]);
     }
     sLocalStorePointers.clear();
 }
 
+void deleteCollisionLocalStoreMemory(void* localStore)
+{
+    CollisionTask_LocalStoreMemory* store = (CollisionTask_LocalStoreMemory*)localStore;
+    int index = sLocalStorePointers.findLinearSearch(store);
+    if (index < sLocalStorePointers.size())
+    {
+        sLocalStorePointers.swap(index,sLocalStorePointers.size()-1);
+        sLocalStorePointers.pop_back();
+        destroyCollisionLocalStore(store);
+    }
+}
+
 #endif
 
 void	ProcessSpuConvexConvexCollision(SpuCollisionPairInput* wuInput, CollisionTask_LocalStoreMemory* lsMemPtr, SpuContactResult& spuContacts);
@@ -48,6 +48,8 @@ void	processCollisionTask(void* userPtr, void* lsMemory);
 
 void*	createCollisionLocalStoreMemory();
 void deleteCollisionLocalStoreMemory();
+///Frees one local store returned by createCollisionLocalStoreMemory, after the thread using it has stopped
+void deleteCollisionLocalStoreMemory(void* localStore);
 
 #if defined(USE_LIBSPE2) && defined(__SPU__)
 #include "../SpuLibspe2Support.h"
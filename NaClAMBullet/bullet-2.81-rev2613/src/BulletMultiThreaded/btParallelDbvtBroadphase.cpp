@@ -0,0 +1,66 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2013 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btParallelDbvtBroadphase.h"
+#include "btThreadSupportInterface.h"
+
+void	DbvtCollideThreadFunc(void* userPtr,void* lsMemory)
+{
+	btDbvtCollideBatch* batch = (btDbvtCollideBatch*)userPtr;
+	batch->process();
+}
+
+void*	DbvtCollidelsMemoryFunc()
+{
+	return 0;
+}
+
+btParallelDbvtBroadphase::btParallelDbvtBroadphase(btThreadSupportInterface* threadInterface,btOverlappingPairCache* paircache)
+:btDbvtBroadphase(paircache),
+m_threadInterface(threadInterface)
+{
+	m_splitdepth = PARALLEL_DBVT_SPLIT_DEPTH;
+	m_splitbatches = threadInterface->getNumTasks()*PARALLEL_DBVT_BATCHES_PER_THREAD;
+}
+
+void	btParallelDbvtBroadphase::collideBatches(btDbvtCollideBatch* batches,int numBatches)
+{
+	const int maxTasks = m_threadInterface->getNumTasks();
+	if (maxTasks<2 || numBatches<2)
+	{
+		btDbvtBroadphase::collideBatches(batches,numBatches);
+		return;
+	}
+	//command 1 runs the thread function on the batch, each thread is handed the next batch when it reports back
+	int next = 0;
+	int busy = 0;
+	for (int t=0;t<maxTasks && next<numBatches;t++)
+	{
+		m_threadInterface->sendRequest(1,(ppu_address_t)&batches[next++],t);
+		busy++;
+	}
+	while (busy>0)
+	{
+		unsigned int taskId = 0;
+		unsigned int status = 0;
+		m_threadInterface->waitForResponse(&taskId,&status);
+		busy--;
+		if (next<numBatches)
+		{
+			m_threadInterface->sendRequest(1,(ppu_address_t)&batches[next++],taskId);
+			busy++;
+		}
+	}
+}
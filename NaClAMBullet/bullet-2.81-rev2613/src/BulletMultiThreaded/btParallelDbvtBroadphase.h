@@ -0,0 +1,48 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2013 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_PARALLEL_DBVT_BROADPHASE_H
+#define BT_PARALLEL_DBVT_BROADPHASE_H
+
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+
+///Subtree pairs of a tree/tree collide are split into this many batches per thread, so threads that finish early pick up more work
+#define PARALLEL_DBVT_BATCHES_PER_THREAD 4
+///Depth below the root pair the tree/tree collides split at
+#define PARALLEL_DBVT_SPLIT_DEPTH 6
+
+void	DbvtCollideThreadFunc(void* userPtr,void* lsMemory);
+void*	DbvtCollidelsMemoryFunc();
+
+///btParallelDbvtBroadphase collides the dynamic set against itself and the fixed set on worker threads.
+///The traversal is split into subtree pairs at a fixed depth, each thread collects the pairs of a batch of them and the batches are added to the pair cache in order,
+///so the pairs and their order are the same as with btDbvtBroadphase. The thread support must be created with DbvtCollideThreadFunc and DbvtCollidelsMemoryFunc.
+class btParallelDbvtBroadphase : public btDbvtBroadphase
+{
+protected:
+
+	class	btThreadSupportInterface*	m_threadInterface;
+
+public:
+
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btParallelDbvtBroadphase(class btThreadSupportInterface* threadInterface,btOverlappingPairCache* paircache=0);
+
+	virtual void	collideBatches(btDbvtCollideBatch* batches,int numBatches);
+
+};
+
+#endif //BT_PARALLEL_DBVT_BROADPHASE_H
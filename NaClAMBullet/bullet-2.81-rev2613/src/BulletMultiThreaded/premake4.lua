@@ -0,0 +1,17 @@
+	project "BulletMultiThreaded"
+		
+	kind "StaticLib"
+	targetdir "../../lib"
+	includedirs {
+		"..",
+	}
+	files {
+		"*.cpp",
+		"*.h",
+		"SpuNarrowPhaseCollisionTask/*.cpp",
+		"SpuNarrowPhaseCollisionTask/*.h"
+	}
+	excludes {
+		"btGpu3DGridBroadphase.cpp",
+		"SpuLibspe2Support.cpp"
+	}
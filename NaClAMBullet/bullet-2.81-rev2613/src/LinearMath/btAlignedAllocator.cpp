@@ -14,11 +14,30 @@ subject to the following restrictions:
 */
 
 #include "btAlignedAllocator.h"
+#include <stdio.h>
 
 int gNumAlignedAllocs = 0;
 int gNumAlignedFree = 0;
 int gTotalBytesAlignedAllocs = 0;//detect memory leaks
 
+#ifdef _MSC_VER
+#define BT_ALLOC_THREAD_LOCAL __declspec(thread)
+#else
+#define BT_ALLOC_THREAD_LOCAL __thread
+#endif
+
+///Per thread totals for btAlignedAllocGetThreadStats, unlike the counters above they are exact when several threads allocate
+static BT_ALLOC_THREAD_LOCAL int		gThreadNumAllocs = 0;
+static BT_ALLOC_THREAD_LOCAL int		gThreadNumFrees = 0;
+static BT_ALLOC_THREAD_LOCAL size_t	gThreadNumBytes = 0;
+
+void btAlignedAllocGetThreadStats(btAlignedAllocStats* stats)
+{
+	stats->m_numAllocs = gThreadNumAllocs;
+	stats->m_numFrees = gThreadNumFrees;
+	stats->m_numBytes = gThreadNumBytes;
+}
+
 static void *btAllocDefault(size_t size)
 {
 	return malloc(size);
@@ -115,6 +134,8 @@ void*   btAlignedAllocInternal  (size_t size, int alignment,int line,char* filen
 
  gTotalBytesAlignedAllocs += size;
  gNumAlignedAllocs++;
+ gThreadNumAllocs++;
+ gThreadNumBytes += size;
 
  
  real = (char *)sAllocFunc(size + 2*sizeof(void *) + (alignment-1));
@@ -139,6 +160,7 @@ void    btAlignedFreeInternal   (void* ptr,int line,char* filename)
 
  void* real;
  gNumAlignedFree++;
+ gThreadNumFrees++;
 
  if (ptr) {
    real = *((void **)(ptr)-1);
@@ -159,8 +181,17 @@ void    btAlignedFreeInternal   (void* ptr,int line,char* filename)
 void*	btAlignedAllocInternal	(size_t size, int alignment)
 {
 	gNumAlignedAllocs++;
+	gThreadNumAllocs++;
+	gThreadNumBytes += size;
 	void* ptr;
 	ptr = sAlignedAllocFunc(size, alignment);
+	//SSE builds load and store __m128 members with aligned instructions, custom allocators must honour the alignment.
+	//Checked in release builds too, a misaligned block would otherwise fault far from the allocator that caused it
+	if (((size_t)ptr & (alignment-1)) != 0)
+	{
+		fprintf(stderr,"btAlignedAlloc: %p is not aligned to %d bytes, check btAlignedAllocSetCustomAligned\n",ptr,alignment);
+		abort();
+	}
 //	printf("btAlignedAllocInternal %d, %x\n",size,ptr);
 	return ptr;
 }
@@ -173,6 +204,7 @@ void	btAlignedFreeInternal	(void* ptr)
 	}
 
 	gNumAlignedFree++;
+	gThreadNumFrees++;
 //	printf("btAlignedFreeInternal %x\n",ptr);
 	sAlignedFreeFunc(ptr);
 }
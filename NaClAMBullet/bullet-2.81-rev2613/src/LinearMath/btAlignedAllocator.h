@@ -54,6 +54,18 @@ void btAlignedAllocSetCustom(btAllocFunc *allocFunc, btFreeFunc *freeFunc);
 ///If the developer has already an custom aligned allocator, then btAlignedAllocSetCustomAligned can be used. The default aligned allocator pre-allocates extra memory using the non-aligned allocator, and instruments it.
 void btAlignedAllocSetCustomAligned(btAlignedAllocFunc *allocFunc, btAlignedFreeFunc *freeFunc);
 
+///Running totals of the aligned allocations and frees made by one thread. The difference between two
+///btAlignedAllocGetThreadStats calls counts what the thread allocated in between, for example during one simulation step.
+struct btAlignedAllocStats
+{
+	int		m_numAllocs;
+	int		m_numFrees;
+	size_t	m_numBytes;
+};
+
+///Returns the totals of the calling thread, allocations made by other threads are not included.
+void btAlignedAllocGetThreadStats(btAlignedAllocStats* stats);
+
 
 ///The btAlignedAllocator is a portable class for aligned memory allocations.
 ///Default implementations for unaligned and aligned allocations can be overridden by a custom allocator using btAlignedAllocSetCustom and btAlignedAllocSetCustomAligned.
@@ -101,6 +113,25 @@ public:
 	friend bool operator==( const self_type & , const self_type & ) { return true; }
 };
 
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+#define BT_IS_TRIVIALLY_COPYABLE(T) __is_trivially_copyable(T)
+#elif defined(__GNUC__) || defined(_MSC_VER)
+#define BT_IS_TRIVIALLY_COPYABLE(T) (__has_trivial_copy(T) && __has_trivial_destructor(T))
+#else
+#define BT_IS_TRIVIALLY_COPYABLE(T) 0
+#endif
+
+///btIsTriviallyRelocatable tells btAlignedObjectArray that elements of type T can be moved to a new buffer with memcpy,
+///skipping the copy constructor and destructor. Types whose copy constructor only copies members, such as btVector3, opt in
+///with BT_DECLARE_TRIVIALLY_RELOCATABLE after their declaration. Types holding pointers into themselves must not.
+template <typename T>
+struct btIsTriviallyRelocatable
+{
+	enum { m_value = BT_IS_TRIVIALLY_COPYABLE(T) };
+};
+
+#define BT_DECLARE_TRIVIALLY_RELOCATABLE(T) \
+	template <> struct btIsTriviallyRelocatable<T> { enum { m_value = 1 }; };
 
 
 #endif //BT_ALIGNED_ALLOCATOR
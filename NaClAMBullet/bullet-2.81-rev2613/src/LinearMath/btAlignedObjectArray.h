@@ -32,8 +32,8 @@ subject to the following restrictions:
 
 #ifdef BT_USE_MEMCPY
 #include <memory.h>
-#include <string.h>
 #endif //BT_USE_MEMCPY
+#include <string.h> //for memcpy of trivially relocatable elements
 
 #ifdef BT_USE_PLACEMENT_NEW
 #include <new> //for placement new
@@ -67,9 +67,10 @@ private:
 #endif//BT_ALLOW_ARRAY_COPY_OPERATOR
 
 protected:
+		///grow geometrically, starting from a cache line worth of small elements rather than 1, 2, 4... reallocations
 		SIMD_FORCE_INLINE	int	allocSize(int size)
 		{
-			return (size ? size*2 : 1);
+			return (size ? size*2 : (sizeof(T) < 64 ? int(64/sizeof(T)) : 1));
 		}
 		SIMD_FORCE_INLINE	void	copy(int start,int end, T* dest) const
 		{
@@ -303,9 +304,16 @@ protected:
 			{	// not enough room, reallocate
 				T*	s = (T*)allocate(_Count);
 
-				copy(0, size(), s);
+				if (btIsTriviallyRelocatable<T>::m_value)
+				{
+					if (m_size > 0)
+						memcpy((void*)s, (const void*)m_data, size_t(m_size)*sizeof(T));
+				} else
+				{
+					copy(0, size(), s);
 
-				destroy(0,size());
+					destroy(0,size());
+				}
 
 				deallocate();
 				
@@ -508,4 +516,43 @@ protected:
 
 };
 
+///btSmallAlignedObjectArray keeps up to N elements in storage inside the array object, so a local array of a few elements
+///costs no heap allocation. It moves to the heap when it grows beyond N, and clear() returns it to the inline storage.
+///It can be passed wherever a btAlignedObjectArray<T>& is expected.
+template <typename T, int N>
+class btSmallAlignedObjectArray : public btAlignedObjectArray<T>
+{
+	ATTRIBUTE_ALIGNED16(char	m_inlineStorage[N*sizeof(T)]);
+
+public:
+
+	btSmallAlignedObjectArray()
+	{
+		this->initializeFromBuffer(m_inlineStorage, 0, N);
+	}
+
+	btSmallAlignedObjectArray(const btSmallAlignedObjectArray& otherArray)
+		:btAlignedObjectArray<T>()
+	{
+		this->initializeFromBuffer(m_inlineStorage, 0, N);
+		this->copyFromArray(otherArray);
+	}
+
+	~btSmallAlignedObjectArray()
+	{
+		btAlignedObjectArray<T>::clear();
+	}
+
+	btSmallAlignedObjectArray& operator=(const btSmallAlignedObjectArray& otherArray)
+	{
+		this->copyFromArray(otherArray);
+		return *this;
+	}
+
+	void	clear()
+	{
+		this->initializeFromBuffer(m_inlineStorage, 0, N);
+	}
+};
+
 #endif //BT_OBJECT_ARRAY__
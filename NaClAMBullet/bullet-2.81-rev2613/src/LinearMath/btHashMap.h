@@ -447,4 +447,320 @@ protected:
 
 };
 
+///The btFlatHashMap template class has the interface of btHashMap, but uses open addressing instead of
+///bucket chains. Slots are probed in groups of 16, and each slot has a control byte holding 7 bits of the
+///hash of its key, so one SSE2 compare checks a whole group and keys are only touched on a tag match.
+///Keys and values stay packed in insertion order as in btHashMap, so getAtIndex works the same.
+template <class Key, class Value>
+class btFlatHashMap
+{
+
+protected:
+	enum
+	{
+		BT_FLAT_GROUP_SIZE = 16,
+		//control bytes of full slots hold a 7 bit tag, free slots are negative
+		BT_FLAT_EMPTY = -128,
+		BT_FLAT_DELETED = -2
+	};
+
+	btAlignedObjectArray<signed char>	m_control;
+	btAlignedObjectArray<int>		m_slots;
+	int	m_numDeleted;
+
+	btAlignedObjectArray<Value>		m_valueArray;
+	btAlignedObjectArray<Key>		m_keyArray;
+
+	static SIMD_FORCE_INLINE int	matchTag(const signed char* control, signed char tag)
+	{
+#ifdef BT_USE_SSE
+		__m128i group = _mm_load_si128((const __m128i*)control);
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#else
+		int mask = 0;
+		for (int i=0;i<BT_FLAT_GROUP_SIZE;i++)
+		{
+			if (control[i] == tag)
+				mask |= 1<<i;
+		}
+		return mask;
+#endif
+	}
+
+	static SIMD_FORCE_INLINE int	matchFree(const signed char* control)
+	{
+#ifdef BT_USE_SSE
+		return _mm_movemask_epi8(_mm_load_si128((const __m128i*)control));
+#else
+		int mask = 0;
+		for (int i=0;i<BT_FLAT_GROUP_SIZE;i++)
+		{
+			if (control[i] < 0)
+				mask |= 1<<i;
+		}
+		return mask;
+#endif
+	}
+
+	static SIMD_FORCE_INLINE int	lowestBit(int mask)
+	{
+#ifdef __GNUC__
+		return __builtin_ctz(mask);
+#else
+		int bit = 0;
+		while (!(mask & (1<<bit)))
+			bit++;
+		return bit;
+#endif
+	}
+
+	int	findSlot(const Key& key, unsigned int hash) const
+	{
+		if (m_control.size() == 0)
+		{
+			return BT_HASH_NULL;
+		}
+		signed char tag = (signed char)(hash & 0x7f);
+		int groupMask = m_control.size()/BT_FLAT_GROUP_SIZE - 1;
+		int group = (hash >> 7) & groupMask;
+		//triangular steps visit every group of a power of two table
+		for (int probe=1;;probe++)
+		{
+			const signed char* control = &m_control[group*BT_FLAT_GROUP_SIZE];
+			int match = matchTag(control, tag);
+			while (match)
+			{
+				int slot = group*BT_FLAT_GROUP_SIZE + lowestBit(match);
+				if (key.equals(m_keyArray[m_slots[slot]]))
+				{
+					return slot;
+				}
+				match &= match-1;
+			}
+			if (matchTag(control, BT_FLAT_EMPTY))
+			{
+				return BT_HASH_NULL;
+			}
+			group = (group + probe) & groupMask;
+		}
+	}
+
+	void	insertSlot(unsigned int hash, int index)
+	{
+		int groupMask = m_control.size()/BT_FLAT_GROUP_SIZE - 1;
+		int group = (hash >> 7) & groupMask;
+		for (int probe=1;;probe++)
+		{
+			int match = matchFree(&m_control[group*BT_FLAT_GROUP_SIZE]);
+			if (match)
+			{
+				int slot = group*BT_FLAT_GROUP_SIZE + lowestBit(match);
+				if (m_control[slot] == BT_FLAT_DELETED)
+				{
+					m_numDeleted--;
+				}
+				m_control[slot] = (signed char)(hash & 0x7f);
+				m_slots[slot] = index;
+				return;
+			}
+			group = (group + probe) & groupMask;
+		}
+	}
+
+	static int	slotsFor(int count)
+	{
+		//at most 7/8 of the slots are in use, so that every probe ends at an empty slot
+		int slots = BT_FLAT_GROUP_SIZE;
+		while (slots - slots/8 < count)
+		{
+			slots *= 2;
+		}
+		return slots;
+	}
+
+	void	rehash(int numSlots)
+	{
+		m_control.resize(numSlots);
+		m_slots.resize(numSlots);
+		for (int i=0;i<numSlots;i++)
+		{
+			m_control[i] = BT_FLAT_EMPTY;
+		}
+		m_numDeleted = 0;
+		for (int i=0;i<m_keyArray.size();i++)
+		{
+			insertSlot(m_keyArray[i].getHash(), i);
+		}
+	}
+
+	public:
+
+	btFlatHashMap()
+		:m_numDeleted(0)
+	{
+	}
+
+	///makes room for count keys, without growing or rehashing until there are more
+	void	reserve(int count)
+	{
+		m_valueArray.reserve(count);
+		m_keyArray.reserve(count);
+		int numSlots = slotsFor(count);
+		if (numSlots > m_control.size())
+		{
+			rehash(numSlots);
+		}
+	}
+
+	void insert(const Key& key, const Value& value) {
+		unsigned int hash = key.getHash();
+
+		//replace value if the key is already there
+		int slot = findSlot(key, hash);
+		if (slot != BT_HASH_NULL)
+		{
+			m_valueArray[m_slots[slot]] = value;
+			return;
+		}
+
+		int count = m_valueArray.size();
+		if (count + 1 + m_numDeleted > m_control.size() - m_control.size()/8)
+		{
+			//a rehash drops the deleted slots, so only grow when they are few
+			int numSlots = slotsFor(count + 1);
+			if (numSlots == m_control.size() && m_numDeleted < numSlots/16)
+			{
+				numSlots *= 2;
+			}
+			rehash(numSlots);
+		}
+		m_valueArray.push_back(value);
+		m_keyArray.push_back(key);
+		insertSlot(hash, count);
+	}
+
+	void remove(const Key& key) {
+
+		int slot = findSlot(key, key.getHash());
+		if (slot == BT_HASH_NULL)
+		{
+			return;
+		}
+		int pairIndex = m_slots[slot];
+
+		//a probe stops at the first group with an empty slot, so such a group needs no tombstone
+		const signed char* group = &m_control[slot & ~(BT_FLAT_GROUP_SIZE-1)];
+		if (matchTag(group, BT_FLAT_EMPTY))
+		{
+			m_control[slot] = BT_FLAT_EMPTY;
+		} else
+		{
+			m_control[slot] = BT_FLAT_DELETED;
+			m_numDeleted++;
+		}
+
+		// Move the last pair into the spot of the removed one, and point its slot there
+		int lastPairIndex = m_valueArray.size() - 1;
+		if (lastPairIndex != pairIndex)
+		{
+			int lastSlot = findSlot(m_keyArray[lastPairIndex], m_keyArray[lastPairIndex].getHash());
+			btAssert(lastSlot != BT_HASH_NULL);
+			m_slots[lastSlot] = pairIndex;
+			m_valueArray[pairIndex] = m_valueArray[lastPairIndex];
+			m_keyArray[pairIndex] = m_keyArray[lastPairIndex];
+		}
+		m_valueArray.pop_back();
+		m_keyArray.pop_back();
+	}
+
+
+	int size() const
+	{
+		return m_valueArray.size();
+	}
+
+	const Value* getAtIndex(int index) const
+	{
+		btAssert(index < m_valueArray.size());
+
+		return &m_valueArray[index];
+	}
+
+	Value* getAtIndex(int index)
+	{
+		btAssert(index < m_valueArray.size());
+
+		return &m_valueArray[index];
+	}
+
+	Value* operator[](const Key& key) {
+		return find(key);
+	}
+
+	const Value*	find(const Key& key) const
+	{
+		int index = findIndex(key);
+		if (index == BT_HASH_NULL)
+		{
+			return NULL;
+		}
+		return &m_valueArray[index];
+	}
+
+	Value*	find(const Key& key)
+	{
+		int index = findIndex(key);
+		if (index == BT_HASH_NULL)
+		{
+			return NULL;
+		}
+		return &m_valueArray[index];
+	}
+
+	int	findIndex(const Key& key) const
+	{
+		int slot = findSlot(key, key.getHash());
+		return slot == BT_HASH_NULL ? BT_HASH_NULL : m_slots[slot];
+	}
+
+	///looks up numKeys keys, writing a pointer to the value of each or NULL.
+	///The first control group of each key in a batch is prefetched before any is probed, so their cache misses overlap
+	void	findMany(const Key* keys, int numKeys, Value** values)
+	{
+		const int batchSize = 16;
+		unsigned int hashes[batchSize];
+		for (int begin=0;begin<numKeys;begin+=batchSize)
+		{
+			int end = begin + batchSize < numKeys ? begin + batchSize : numKeys;
+			for (int i=begin;i<end;i++)
+			{
+				hashes[i-begin] = keys[i].getHash();
+#ifdef BT_USE_SSE
+				if (m_control.size())
+				{
+					int group = (hashes[i-begin] >> 7) & (m_control.size()/BT_FLAT_GROUP_SIZE - 1);
+					_mm_prefetch((const char*)&m_control[group*BT_FLAT_GROUP_SIZE], _MM_HINT_T0);
+					_mm_prefetch((const char*)&m_slots[group*BT_FLAT_GROUP_SIZE], _MM_HINT_T0);
+				}
+#endif
+			}
+			for (int i=begin;i<end;i++)
+			{
+				int slot = findSlot(keys[i], hashes[i-begin]);
+				values[i] = slot == BT_HASH_NULL ? NULL : &m_valueArray[m_slots[slot]];
+			}
+		}
+	}
+
+	void	clear()
+	{
+		m_control.clear();
+		m_slots.clear();
+		m_numDeleted = 0;
+		m_valueArray.clear();
+		m_keyArray.clear();
+	}
+
+};
+
 #endif //BT_HASH_MAP_H
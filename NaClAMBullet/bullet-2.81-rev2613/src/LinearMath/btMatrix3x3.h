@@ -736,6 +736,8 @@ public:
 
 };
 
+BT_DECLARE_TRIVIALLY_RELOCATABLE(btMatrix3x3)
+
 
 SIMD_FORCE_INLINE btMatrix3x3& 
 btMatrix3x3::operator*=(const btMatrix3x3& m)
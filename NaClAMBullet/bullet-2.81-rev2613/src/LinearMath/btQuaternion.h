@@ -531,6 +531,8 @@ public:
 	
 };
 
+BT_DECLARE_TRIVIALLY_RELOCATABLE(btQuaternion)
+
 
 
 
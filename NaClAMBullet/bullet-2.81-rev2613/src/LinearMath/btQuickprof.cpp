@@ -422,10 +422,77 @@ void	CProfileIterator::Enter_Parent( void )
 **
 ***************************************************************************************************/
 
-CProfileNode	CProfileManager::Root( "Root", NULL );
-CProfileNode *	CProfileManager::CurrentNode = &CProfileManager::Root;
-int				CProfileManager::FrameCounter = 0;
-unsigned long int			CProfileManager::ResetTime = 0;
+#ifdef _MSC_VER
+#define BT_PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define BT_PROFILE_THREAD_LOCAL __thread
+#endif
+
+///Per thread profiling state. A thread's tree is created on first use and deleted when the
+///thread exits, so short lived worker threads do not leak their trees.
+static BT_PROFILE_THREAD_LOCAL CProfileNode *	gRoot = 0;
+static BT_PROFILE_THREAD_LOCAL CProfileNode *	gCurrentNode = 0;
+static BT_PROFILE_THREAD_LOCAL int				gFrameCounter = 0;
+static BT_PROFILE_THREAD_LOCAL unsigned long int	gResetTime = 0;
+
+static void destroyProfileRoot( void * root )
+{
+	delete (CProfileNode *)root;
+	gRoot = 0;
+	gCurrentNode = 0;
+}
+
+#if defined(BT_USE_WINDOWS_TIMERS) && !defined(_XBOX)
+
+static VOID WINAPI destroyProfileRootFls( PVOID root )
+{
+	destroyProfileRoot( root );
+}
+
+static void registerProfileRoot( CProfileNode * root )
+{
+	static DWORD rootIndex = FlsAlloc( destroyProfileRootFls );
+	if (rootIndex != FLS_OUT_OF_INDEXES)
+		FlsSetValue( rootIndex, root );
+}
+
+#elif !defined(BT_USE_WINDOWS_TIMERS) && !defined(__CELLOS_LV2__)
+
+#include <pthread.h>
+
+static pthread_key_t gRootKey;
+static pthread_once_t gRootKeyOnce = PTHREAD_ONCE_INIT;
+
+static void createProfileRootKey( void )
+{
+	pthread_key_create( &gRootKey, destroyProfileRoot );
+}
+
+static void registerProfileRoot( CProfileNode * root )
+{
+	pthread_once( &gRootKeyOnce, createProfileRootKey );
+	pthread_setspecific( gRootKey, root );
+}
+
+#else
+
+static void registerProfileRoot( CProfileNode * )
+{
+}
+
+#endif
+
+
+CProfileNode * CProfileManager::Get_Root( void )
+{
+	if (!gRoot)
+	{
+		gRoot = new CProfileNode( "Root", NULL );
+		gCurrentNode = gRoot;
+		registerProfileRoot( gRoot );
+	}
+	return gRoot;
+}
 
 
 /***********************************************************************************************
@@ -443,11 +510,12 @@ unsigned long int			CProfileManager::ResetTime = 0;
  *=============================================================================================*/
 void	CProfileManager::Start_Profile( const char * name )
 {
-	if (name != CurrentNode->Get_Name()) {
-		CurrentNode = CurrentNode->Get_Sub_Node( name );
+	Get_Root();
+	if (name != gCurrentNode->Get_Name()) {
+		gCurrentNode = gCurrentNode->Get_Sub_Node( name );
 	} 
 	
-	CurrentNode->Call();
+	gCurrentNode->Call();
 }
 
 
@@ -458,8 +526,8 @@ void	CProfileManager::Stop_Profile( void )
 {
 	// Return will indicate whether we should back up to our parent (we may
 	// be profiling a recursive function)
-	if (CurrentNode->Return()) {
-		CurrentNode = CurrentNode->Get_Parent();
+	if (gCurrentNode->Return()) {
+		gCurrentNode = gCurrentNode->Get_Parent();
 	}
 }
 
@@ -471,11 +539,12 @@ void	CProfileManager::Stop_Profile( void )
  *=============================================================================================*/
 void	CProfileManager::Reset( void )
 { 
-	gProfileClock.reset();
-	Root.Reset();
-    Root.Call();
-	FrameCounter = 0;
-	Profile_Get_Ticks(&ResetTime);
+	// The clock is shared by every thread's tree so it is not reset, the time since
+	// reset is taken relative to gResetTime instead
+	Get_Root()->Reset();
+	gRoot->Call();
+	gFrameCounter = 0;
+	Profile_Get_Ticks(&gResetTime);
 }
 
 
@@ -484,7 +553,16 @@ void	CProfileManager::Reset( void )
  *=============================================================================================*/
 void CProfileManager::Increment_Frame_Counter( void )
 {
-	FrameCounter++;
+	gFrameCounter++;
+}
+
+
+/***********************************************************************************************
+ * CProfileManager::Get_Frame_Count_Since_Reset -- frames counted since the last reset        *
+ *=============================================================================================*/
+int CProfileManager::Get_Frame_Count_Since_Reset( void )
+{
+	return gFrameCounter;
 }
 
 
@@ -495,7 +573,7 @@ float CProfileManager::Get_Time_Since_Reset( void )
 {
 	unsigned long int time;
 	Profile_Get_Ticks(&time);
-	time -= ResetTime;
+	time -= gResetTime;
 	return (float)time / Profile_Get_Tick_Rate();
 }
 
@@ -138,6 +138,8 @@ protected:
 
 
 ///The Manager for the Profile system
+///Each thread records into its own tree, so worlds stepped on separate threads can profile
+///at the same time. All calls, including Get_Iterator, act on the calling thread's tree.
 class	CProfileManager {
 public:
 	static	void						Start_Profile( const char * name );
@@ -145,18 +147,18 @@ public:
 
 	static	void						CleanupMemory(void)
 	{
-		Root.CleanupMemory();
+		Get_Root()->CleanupMemory();
 	}
 
 	static	void						Reset( void );
 	static	void						Increment_Frame_Counter( void );
-	static	int						Get_Frame_Count_Since_Reset( void )		{ return FrameCounter; }
+	static	int						Get_Frame_Count_Since_Reset( void );
 	static	float						Get_Time_Since_Reset( void );
 
 	static	CProfileIterator *	Get_Iterator( void )	
 	{ 
 		
-		return new CProfileIterator( &Root ); 
+		return new CProfileIterator( Get_Root() ); 
 	}
 	static	void						Release_Iterator( CProfileIterator * iterator ) { delete ( iterator); }
 
@@ -165,10 +167,8 @@ public:
 	static void	dumpAll();
 
 private:
-	static	CProfileNode			Root;
-	static	CProfileNode *			CurrentNode;
-	static	int						FrameCounter;
-	static	unsigned long int					ResetTime;
+	///The calling thread's tree, created on first use
+	static	CProfileNode *			Get_Root( void );
 };
 
 
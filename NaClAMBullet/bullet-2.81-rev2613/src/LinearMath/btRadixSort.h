@@ -0,0 +1,143 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2013 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef BT_RADIX_SORT_H
+#define BT_RADIX_SORT_H
+
+#include "btAlignedObjectArray.h"
+
+///btRadixSort orders a btAlignedObjectArray by an integer key per element, such as the island id of a manifold or constraint.
+///The key function runs once per element instead of twice per comparison, and elements with equal keys keep their order.
+///It is a least significant digit radix sort over 8 bit digits, keys are taken relative to the smallest key so that only
+///the digits needed for the key range are sorted, island ids usually take two passes. Short arrays use an insertion sort.
+///The scratch buffers are kept between calls, so sorting every simulation step does not allocate once they are large enough.
+template <typename T>
+class btRadixSort
+{
+	struct	btRadixSortItem
+	{
+		unsigned int	m_key;
+		T				m_value;
+	};
+
+	btAlignedObjectArray<btRadixSortItem>	m_items;
+	btAlignedObjectArray<btRadixSortItem>	m_scratch;
+
+	void	insertionSort(btRadixSortItem* items, int numItems)
+	{
+		for (int i=1;i<numItems;i++)
+		{
+			btRadixSortItem item = items[i];
+			int j = i;
+			while (j>0 && items[j-1].m_key > item.m_key)
+			{
+				items[j] = items[j-1];
+				j--;
+			}
+			items[j] = item;
+		}
+	}
+
+public:
+
+	///arrays up to this size are insertion sorted
+	enum { BT_RADIX_SORT_MIN_SIZE = 32 };
+
+	///KeyFunc is called as int getKey(const T&)
+	template <typename KeyFunc>
+	void	sort(btAlignedObjectArray<T>& array, const KeyFunc& getKey)
+	{
+		int numItems = array.size();
+		if (numItems < 2)
+			return;
+
+		m_items.resizeNoInitialize(numItems);
+		btRadixSortItem* items = &m_items[0];
+		int minKey = getKey(array[0]);
+		int maxKey = minKey;
+		int i;
+		for (i=0;i<numItems;i++)
+		{
+			int key = getKey(array[i]);
+			minKey = key < minKey ? key : minKey;
+			maxKey = key > maxKey ? key : maxKey;
+			items[i].m_key = (unsigned int)key;
+			items[i].m_value = array[i];
+		}
+		unsigned int keyRange = (unsigned int)maxKey - (unsigned int)minKey;
+		if (keyRange == 0)
+			return;
+
+		if (numItems <= BT_RADIX_SORT_MIN_SIZE)
+		{
+			for (i=0;i<numItems;i++)
+			{
+				items[i].m_key -= (unsigned int)minKey;
+			}
+			insertionSort(items, numItems);
+		} else
+		{
+			int numPasses = 1;
+			while (numPasses < 4 && (keyRange >> (8*numPasses)))
+			{
+				numPasses++;
+			}
+			//count all digits in one sweep
+			int counts[4][256];
+			memset(counts, 0, sizeof(counts[0])*numPasses);
+			for (i=0;i<numItems;i++)
+			{
+				unsigned int key = items[i].m_key - (unsigned int)minKey;
+				items[i].m_key = key;
+				for (int pass=0;pass<numPasses;pass++)
+				{
+					counts[pass][(key >> (8*pass)) & 0xff]++;
+				}
+			}
+
+			m_scratch.resizeNoInitialize(numItems);
+			btRadixSortItem* src = items;
+			btRadixSortItem* dst = &m_scratch[0];
+			for (int pass=0;pass<numPasses;pass++)
+			{
+				int* count = counts[pass];
+				int offset = 0;
+				for (int digit=0;digit<256;digit++)
+				{
+					int c = count[digit];
+					count[digit] = offset;
+					offset += c;
+				}
+				int shift = 8*pass;
+				for (i=0;i<numItems;i++)
+				{
+					dst[count[(src[i].m_key >> shift) & 0xff]++] = src[i];
+				}
+				btRadixSortItem* tmp = src;
+				src = dst;
+				dst = tmp;
+			}
+			items = src;
+		}
+
+		for (i=0;i<numItems;i++)
+		{
+			array[i] = items[i].m_value;
+		}
+	}
+};
+
+#endif //BT_RADIX_SORT_H
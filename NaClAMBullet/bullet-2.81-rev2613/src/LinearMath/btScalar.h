@@ -218,6 +218,47 @@ inline int	btGetVersion()
 	#define btLikely(_c)  _c
 	#define btUnlikely(_c) _c
 
+#elif (defined (__GNUC__) && (defined (__i386__) || defined (__x86_64__)) && defined (__SSE2__) && (!defined (BT_USE_DOUBLE_PRECISION)) && (!defined (BT_DISABLE_SSE)))
+		//GCC and Clang on x86 and x86-64, including Native Client, when building with SSE2.
+		//Define BT_DISABLE_SSE to build the scalar code instead.
+		#define BT_USE_SSE
+		//BT_USE_SSE_IN_API stores btVector3, btQuaternion and btMatrix3x3 rows as __m128.
+		//Heap allocated objects that contain them need 16 byte alignment, which btAlignedAlloc
+		//and BT_DECLARE_ALIGNED_ALLOCATOR provide and plain malloc does not on all x86 targets
+		#define BT_USE_SSE_IN_API
+		#if defined (__SSE4_1__)
+			#include <smmintrin.h>
+		#elif defined (__SSSE3__)
+			#include <tmmintrin.h>
+		#elif defined (__SSE3__)
+			#include <pmmintrin.h>
+		#else
+			#include <emmintrin.h>
+		#endif
+		//btVector3::maxDot and minDot pick an SSE2 or AVX kernel for the running CPU,
+		//which needs function target attributes and __builtin_cpu_supports from GCC 4.9
+		#if (!defined (__clang__)) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+			#define BT_USE_SIMD_DISPATCH
+		#endif
+
+		#define SIMD_FORCE_INLINE inline __attribute__ ((always_inline))
+		#define ATTRIBUTE_ALIGNED16(a) a __attribute__ ((aligned (16)))
+		#define ATTRIBUTE_ALIGNED64(a) a __attribute__ ((aligned (64)))
+		#define ATTRIBUTE_ALIGNED128(a) a __attribute__ ((aligned (128)))
+		#ifndef assert
+		#include <assert.h>
+		#endif
+
+#if defined(DEBUG) || defined (_DEBUG)
+		#define btAssert assert
+#else
+		#define btAssert(x)
+#endif
+
+		//btFullAssert is optional, slows down a lot
+		#define btFullAssert(x)
+		#define btLikely(_c)  _c
+		#define btUnlikely(_c) _c
 #else
 
 		#define SIMD_FORCE_INLINE inline
@@ -148,11 +148,11 @@ class btDefaultSerializer	:	public btSerializer
 	btHashMap<btHashString,int>	mTypeLookup;
 
 	
-	btHashMap<btHashPtr,void*>	m_chunkP;
+	btFlatHashMap<btHashPtr,void*>	m_chunkP;
 	
-	btHashMap<btHashPtr,const char*>	m_nameMap;
+	btFlatHashMap<btHashPtr,const char*>	m_nameMap;
 
-	btHashMap<btHashPtr,btPointerUid>	m_uniquePointers;
+	btFlatHashMap<btHashPtr,btPointerUid>	m_uniquePointers;
 	int	m_uniqueIdGenerator;
 
 	int					m_totalSize;
@@ -218,6 +218,8 @@ public:
 
 };
 
+BT_DECLARE_TRIVIALLY_RELOCATABLE(btTransform)
+
 
 SIMD_FORCE_INLINE btVector3
 btTransform::invXform(const btVector3& inVec) const
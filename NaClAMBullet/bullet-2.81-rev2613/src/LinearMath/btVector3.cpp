@@ -39,11 +39,178 @@ typedef  float float4 __attribute__ ((vector_size(16)));
 
 #include <emmintrin.h>
 
+static long _maxdot_large_sse( const float *vv, const float *vec, unsigned long count, float *dotResult );
+static long _mindot_large_sse( const float *vv, const float *vec, unsigned long count, float *dotResult );
+
+#ifdef BT_USE_SIMD_DISPATCH
+#include <immintrin.h>
+
+static long _maxdot_large_avx( const float *vv, const float *vec, unsigned long count, float *dotResult );
+static long _mindot_large_avx( const float *vv, const float *vec, unsigned long count, float *dotResult );
+static long _maxdot_large_sel( const float *vv, const float *vec, unsigned long count, float *dotResult );
+static long _mindot_large_sel( const float *vv, const float *vec, unsigned long count, float *dotResult );
+
+long (*_maxdot_large)( const float *vv, const float *vec, unsigned long count, float *dotResult ) = _maxdot_large_sel;
+long (*_mindot_large)( const float *vv, const float *vec, unsigned long count, float *dotResult ) = _mindot_large_sel;
+
+static long _maxdot_large_sel( const float *vv, const float *vec, unsigned long count, float *dotResult )
+{
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx" ) )
+        _maxdot_large = _maxdot_large_avx;
+    else
+        _maxdot_large = _maxdot_large_sse;
+    
+    return _maxdot_large(vv, vec, count, dotResult);
+}
+
+static long _mindot_large_sel( const float *vv, const float *vec, unsigned long count, float *dotResult )
+{
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx" ) )
+        _mindot_large = _mindot_large_avx;
+    else
+        _mindot_large = _mindot_large_sse;
+    
+    return _mindot_large(vv, vec, count, dotResult);
+}
+
+// Eight vertices per iteration, transposed so that each lane holds one dot product. The first pass
+// tracks the best dot of each chunk of 128 vertices and remembers the first chunk that produced
+// the overall best, the second finds the vertex within that chunk. The products are summed in the
+// same order as btVector3::dot, so the result matches the scalar loop exactly. AVX2 and FMA are
+// not used: there is no integer work, and fused multiply adds would round differently from the
+// other paths.
+static inline __attribute__ ((target ("avx"))) __m256 _dot8_avx( const float *p, __m256 vx, __m256 vy, __m256 vz )
+{
+    // 16 byte loads so that no load splits a cache line
+    __m256 a = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( p ) ), _mm_loadu_ps( p + 16 ), 1 );      // v0 | v4
+    __m256 b = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( p + 4 ) ), _mm_loadu_ps( p + 20 ), 1 );  // v1 | v5
+    __m256 c = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( p + 8 ) ), _mm_loadu_ps( p + 24 ), 1 );  // v2 | v6
+    __m256 d = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( p + 12 ) ), _mm_loadu_ps( p + 28 ), 1 ); // v3 | v7
+    __m256 t0 = _mm256_unpacklo_ps( a, b );             // x0 x1 y0 y1 | x4 x5 y4 y5
+    __m256 t1 = _mm256_unpacklo_ps( c, d );             // x2 x3 y2 y3 | x6 x7 y6 y7
+    __m256 t2 = _mm256_unpackhi_ps( a, b );             // z0 z1 w0 w1 | z4 z5 w4 w5
+    __m256 t3 = _mm256_unpackhi_ps( c, d );             // z2 z3 w2 w3 | z6 z7 w6 w7
+    __m256 x = _mm256_shuffle_ps( t0, t1, 0x44 );       // x0 x1 x2 x3 | x4 x5 x6 x7
+    __m256 y = _mm256_shuffle_ps( t0, t1, 0xee );
+    __m256 z = _mm256_shuffle_ps( t2, t3, 0x44 );
+    return _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, vx ), _mm256_mul_ps( y, vy ) ), _mm256_mul_ps( z, vz ) );
+}
+
+template <bool isMax>
+static inline __attribute__ ((target ("avx"))) __m256 _best8_avx( __m256 a, __m256 b )
+{
+    return isMax ? _mm256_max_ps( a, b ) : _mm256_min_ps( a, b );
+}
+
+template <bool isMax>
+static inline __attribute__ ((target ("avx"))) long _dot_large_avx( const float *vv, const float *vec, unsigned long count, float *dotResult )
+{
+    // Below a few blocks the 128 bit kernel is as fast and skips the setup
+    if( count < 64 )
+        return isMax ? _maxdot_large_sse( vv, vec, count, dotResult ) : _mindot_large_sse( vv, vec, count, dotResult );
+    
+    const unsigned long chunkBlocks = 16;
+    const __m256 vx = _mm256_set1_ps( vec[0] );
+    const __m256 vy = _mm256_set1_ps( vec[1] );
+    const __m256 vz = _mm256_set1_ps( vec[2] );
+    unsigned long blocks = count / 8;
+    
+    float result = isMax ? -BT_INFINITY : BT_INFINITY;
+    unsigned long bestChunk = blocks;
+    for( unsigned long chunk = 0; chunk < blocks; chunk += chunkBlocks )
+    {
+        unsigned long end = btMin( chunk + chunkBlocks, blocks );
+        // Two accumulators keep the max/min latency off the critical path
+        __m256 best0 = _dot8_avx( vv + chunk * 32, vx, vy, vz );
+        __m256 best1 = best0;
+        unsigned long i = chunk + 1;
+        for( ; i + 1 < end; i += 2 )
+        {
+            best0 = _best8_avx<isMax>( best0, _dot8_avx( vv + i * 32, vx, vy, vz ) );
+            best1 = _best8_avx<isMax>( best1, _dot8_avx( vv + i * 32 + 32, vx, vy, vz ) );
+        }
+        if( i < end )
+            best0 = _best8_avx<isMax>( best0, _dot8_avx( vv + i * 32, vx, vy, vz ) );
+        
+        best0 = _best8_avx<isMax>( best0, best1 );
+        __m128 m = _mm256_castps256_ps128( best0 );
+        __m128 h = _mm256_extractf128_ps( best0, 1 );
+        m = isMax ? _mm_max_ps( m, h ) : _mm_min_ps( m, h );
+        h = _mm_movehl_ps( m, m );
+        m = isMax ? _mm_max_ps( m, h ) : _mm_min_ps( m, h );
+        h = _mm_shuffle_ps( m, m, 1 );
+        m = isMax ? _mm_max_ss( m, h ) : _mm_min_ss( m, h );
+        float chunkResult = _mm_cvtss_f32( m );
+        if( isMax ? chunkResult > result : chunkResult < result )
+        {
+            result = chunkResult;
+            bestChunk = chunk;
+        }
+    }
+    
+    long resultIndex = -1;
+    if( bestChunk < blocks )
+    {
+        const __m256 target = _mm256_set1_ps( result );
+        for( unsigned long i = bestChunk; i < blocks; i++ )
+        {
+            int mask = _mm256_movemask_ps( _mm256_cmp_ps( _dot8_avx( vv + i * 32, vx, vy, vz ), target, _CMP_EQ_OQ ) );
+            if( mask )
+            {
+                resultIndex = i * 8 + __builtin_ctz( mask );
+                break;
+            }
+        }
+    }
+    
+    for( unsigned long i = blocks * 8; i < count; i++ )
+    {
+        const float *v = vv + i * 4;
+        float dot = v[0] * vec[0] + v[1] * vec[1] + v[2] * vec[2];
+        if( isMax ? dot > result : dot < result )
+        {
+            result = dot;
+            resultIndex = i;
+        }
+    }
+    
+    _mm256_zeroupper();
+    *dotResult = result;
+    return resultIndex;
+}
+
+static __attribute__ ((target ("avx"))) long _maxdot_large_avx( const float *vv, const float *vec, unsigned long count, float *dotResult )
+{
+    return _dot_large_avx<true>( vv, vec, count, dotResult );
+}
+
+static __attribute__ ((target ("avx"))) long _mindot_large_avx( const float *vv, const float *vec, unsigned long count, float *dotResult )
+{
+    return _dot_large_avx<false>( vv, vec, count, dotResult );
+}
+
+#else //BT_USE_SIMD_DISPATCH
+
 long _maxdot_large( const float *vv, const float *vec, unsigned long count, float *dotResult );
 long _maxdot_large( const float *vv, const float *vec, unsigned long count, float *dotResult )
+{
+    return _maxdot_large_sse( vv, vec, count, dotResult );
+}
+
+long _mindot_large( const float *vv, const float *vec, unsigned long count, float *dotResult );
+long _mindot_large( const float *vv, const float *vec, unsigned long count, float *dotResult )
+{
+    return _mindot_large_sse( vv, vec, count, dotResult );
+}
+
+#endif //BT_USE_SIMD_DISPATCH
+
+static long _maxdot_large_sse( const float *vv, const float *vec, unsigned long count, float *dotResult )
 {
     const float4 *vertices = (const float4*) vv;
-    static const unsigned char indexTable[16] = {-1, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+    static const unsigned char indexTable[16] = {(unsigned char)-1, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
     float4 dotMax = btAssign128( -BT_INFINITY,  -BT_INFINITY,  -BT_INFINITY,  -BT_INFINITY );
     float4 vvec = _mm_loadu_ps( vec );
     float4 vHi = btCastiTo128f(_mm_shuffle_epi32( btCastfTo128i( vvec), 0xaa ));          /// zzzz
@@ -423,12 +590,10 @@ long _maxdot_large( const float *vv, const float *vec, unsigned long count, floa
     return maxIndex;
 }
 
-long _mindot_large( const float *vv, const float *vec, unsigned long count, float *dotResult );
-
-long _mindot_large( const float *vv, const float *vec, unsigned long count, float *dotResult )
+static long _mindot_large_sse( const float *vv, const float *vec, unsigned long count, float *dotResult )
 {
     const float4 *vertices = (const float4*) vv;
-    static const unsigned char indexTable[16] = {-1, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+    static const unsigned char indexTable[16] = {(unsigned char)-1, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
     float4 dotmin = btAssign128( BT_INFINITY,  BT_INFINITY,  BT_INFINITY,  BT_INFINITY );
     float4 vvec = _mm_loadu_ps( vec );
     float4 vHi = btCastiTo128f(_mm_shuffle_epi32( btCastfTo128i( vvec), 0xaa ));          /// zzzz
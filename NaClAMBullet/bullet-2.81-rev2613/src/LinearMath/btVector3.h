@@ -732,6 +732,8 @@ public:
     }
 };
 
+BT_DECLARE_TRIVIALLY_RELOCATABLE(btVector3)
+
 /**@brief Return the sum of two vectors (Point symantics)*/
 SIMD_FORCE_INLINE btVector3 
 operator+(const btVector3& v1, const btVector3& v2) 
@@ -989,7 +991,10 @@ SIMD_FORCE_INLINE btVector3 btVector3::rotate( const btVector3& wAxis, const btS
 SIMD_FORCE_INLINE   long    btVector3::maxDot( const btVector3 *array, long array_count, btScalar &dotOut ) const
 {
 #if defined (BT_USE_SSE) || defined (BT_USE_NEON)
-    #if defined _WIN32 || defined (BT_USE_SSE)
+    #if defined (BT_USE_SIMD_DISPATCH)
+        const long scalar_cutoff = 10;
+        extern long (*_maxdot_large)( const float *array, const float *vec, unsigned long array_count, float *dotOut );
+    #elif defined _WIN32 || defined (BT_USE_SSE)
         const long scalar_cutoff = 10;
         long _maxdot_large( const float *array, const float *vec, unsigned long array_count, float *dotOut );
     #elif defined BT_USE_NEON
@@ -1026,7 +1031,10 @@ SIMD_FORCE_INLINE   long    btVector3::maxDot( const btVector3 *array, long arra
 SIMD_FORCE_INLINE   long    btVector3::minDot( const btVector3 *array, long array_count, btScalar &dotOut ) const
 {
 #if defined (BT_USE_SSE) || defined (BT_USE_NEON)
-    #if defined BT_USE_SSE
+    #if defined (BT_USE_SIMD_DISPATCH)
+        const long scalar_cutoff = 10;
+        extern long (*_mindot_large)( const float *array, const float *vec, unsigned long array_count, float *dotOut );
+    #elif defined BT_USE_SSE
         const long scalar_cutoff = 10;
         long _mindot_large( const float *array, const float *vec, unsigned long array_count, float *dotOut );
     #elif defined BT_USE_NEON
@@ -1212,6 +1220,8 @@ public:
 
 };
 
+BT_DECLARE_TRIVIALLY_RELOCATABLE(btVector4)
+
 
 ///btSwapVector3Endian swaps vector endianness, useful for network and cross-platform serialization
 SIMD_FORCE_INLINE void	btSwapScalarEndian(const btScalar& sourceVal, btScalar& destVal)
@@ -56,6 +56,89 @@ function loadShape(shape) {
 		return shapes[shape.name];
 	}
 
+	if (shape.type == "trimesh") {
+		var geometry = new THREE.Geometry();
+		var vertices = shape['vertices'];
+		var indices = shape['indices'];
+		for (var i = 0; i < vertices.length; i += 3) {
+			geometry.vertices.push(new THREE.Vector3(vertices[i], vertices[i+1], vertices[i+2]));
+		}
+		for (var i = 0; i < indices.length; i += 3) {
+			geometry.faces.push(new THREE.Face3(indices[i], indices[i+1], indices[i+2]));
+		}
+		geometry.computeFaceNormals();
+		shapes[shape.name] = geometry;
+		return shapes[shape.name];
+	}
+
+	if (shape.type == "heightfield") {
+		// Match btHeightfieldTerrainShape, which is centred on its bounding box.
+		var geometry = new THREE.Geometry();
+		var width = shape['width'];
+		var length = shape['length'];
+		var heights = shape['heights'];
+		var spacing = shape['spacing'] != undefined ? shape['spacing'] : 1.0;
+		var minHeight = heights[0];
+		var maxHeight = heights[0];
+		for (var i = 0; i < width * length; i++) {
+			minHeight = Math.min(minHeight, heights[i]);
+			maxHeight = Math.max(maxHeight, heights[i]);
+		}
+		var midHeight = (minHeight + maxHeight) * 0.5;
+		for (var j = 0; j < length; j++) {
+			for (var i = 0; i < width; i++) {
+				geometry.vertices.push(new THREE.Vector3((i - (width - 1) * 0.5) * spacing,
+														 heights[j * width + i] - midHeight,
+														 (j - (length - 1) * 0.5) * spacing));
+			}
+		}
+		for (var j = 0; j < length - 1; j++) {
+			for (var i = 0; i < width - 1; i++) {
+				var a = j * width + i;
+				geometry.faces.push(new THREE.Face3(a, a + width, a + 1));
+				geometry.faces.push(new THREE.Face3(a + 1, a + width, a + width + 1));
+			}
+		}
+		geometry.computeFaceNormals();
+		shapes[shape.name] = geometry;
+		return shapes[shape.name];
+	}
+
+	if (shape.type == "compound") {
+		var geometry = new THREE.Geometry();
+		for (var i = 0; i < shape['children'].length; i++) {
+			var child = shape['children'][i];
+			var childGeometry = shapes[child.shape];
+			if (childGeometry == undefined) {
+				continue;
+			}
+			var mesh = new THREE.Mesh(childGeometry);
+			if (child.transform == undefined) {
+				// Children may be placed like bodies, with a position and rotation.
+				if (child.position != undefined) {
+					mesh.position.set(child.position.x, child.position.y, child.position.z);
+				}
+				if (child.rotation != undefined) {
+					mesh.rotation.set(child.rotation.x, child.rotation.y, child.rotation.z);
+				}
+				mesh.updateMatrix();
+				child.transform = [];
+				for (var j = 0; j < 16; j++) {
+					child.transform.push(mesh.matrix.elements[j]);
+				}
+			} else {
+				for (var j = 0; j < 16; j++) {
+					mesh.matrix.elements[j] = child.transform[j];
+				}
+			}
+			mesh.matrixAutoUpdate = false;
+			THREE.GeometryUtils.merge(geometry, mesh);
+		}
+		geometry.computeFaceNormals();
+		shapes[shape.name] = geometry;
+		return shapes[shape.name];
+	}
+
 	return undefined;
 }
 
@@ -129,10 +212,22 @@ function loadWorld(worldDescription) {
 		return;
 	}
 	skipSceneUpdates = 4;
-	NaClAMBulletLoadScene(worldDescription);
+	if (worldDescription.binary != undefined) {
+		NaClAMBulletLoadSceneBinary(worldDescription);
+	} else {
+		NaClAMBulletLoadScene(worldDescription);
+		// Reloads use the converted .bullet file
+		NaClAMBulletSaveSceneBinary();
+	}
+	// Restarting restores this instead of loading the scene again
+	NaClAMBulletSnapshot(0);
 	lastSceneDescription = worldDescription;
 }
 
+function restartScene() {
+	NaClAMBulletRestore(0);
+}
+
 function reloadScene() {
 	if (lastSceneDescription)
 		loadWorld(lastSceneDescription);
@@ -247,11 +342,51 @@ function init() {
 	demoButton.addEventListener('click', load400RandomCubes, false);
 	info.appendChild(demoButton);
 
+	demoButton = document.createElement ('button');
+	demoButton.innerHTML = '400 Debris Cubes';
+	demoButton.addEventListener('click', load400DebrisCubes, false);
+	info.appendChild(demoButton);
+
 	demoButton = document.createElement ('button');
 	demoButton.innerHTML = '400 Random Cylinders';
 	demoButton.addEventListener('click', load400RandomCylinders, false);
 	info.appendChild(demoButton);
 
+	demoButton = document.createElement ('button');
+	demoButton.innerHTML = '100 Tables';
+	demoButton.addEventListener('click', load100Tables, false);
+	info.appendChild(demoButton);
+
+	demoButton = document.createElement ('button');
+	demoButton.innerHTML = 'Falling Cubes';
+	demoButton.addEventListener('click', loadFallingCubes, false);
+	info.appendChild(demoButton);
+
+	demoButton = document.createElement ('button');
+	demoButton.innerHTML = 'Falling Cubes (CCD)';
+	demoButton.addEventListener('click', loadFallingCubesCCD, false);
+	info.appendChild(demoButton);
+
+	demoButton = document.createElement ('button');
+	demoButton.innerHTML = 'Terrain';
+	demoButton.addEventListener('click', loadTerrain, false);
+	info.appendChild(demoButton);
+
+	demoButton = document.createElement ('button');
+	demoButton.innerHTML = 'Stream 10000 Cubes';
+	demoButton.addEventListener('click', stream10000Cubes, false);
+	info.appendChild(demoButton);
+
+	demoButton = document.createElement ('button');
+	demoButton.innerHTML = 'Settle';
+	demoButton.addEventListener('click', settleScene, false);
+	info.appendChild(demoButton);
+
+	demoButton = document.createElement ('button');
+	demoButton.innerHTML = 'Remove 100 Bodies';
+	demoButton.addEventListener('click', remove100Bodies, false);
+	info.appendChild(demoButton);
+
 	demoButton = document.createElement('input');
 	demoButton.innerHTML = 'Upload Scene';
 	demoButton.setAttribute("type", "file");
@@ -275,6 +410,11 @@ function init() {
 	demoButton.addEventListener('click', reloadScene, false);
 	info.appendChild(demoButton);
 
+	demoButton = document.createElement ('button');
+	demoButton.innerHTML = 'Restart Scene';
+	demoButton.addEventListener('click', restartScene, false);
+	info.appendChild(demoButton);
+
 	renderer.domElement.addEventListener('mousemove', onDocumentMouseMove, false );
 	window.addEventListener('resize', onWindowResize, false );
 	window.addEventListener('keydown', onDocumentKeyDown, false);
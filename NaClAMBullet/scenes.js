@@ -143,6 +143,7 @@ function randomShapeScene(numObjects) {
 	worldDescription.shapes.push({
 		name: 'tri',
 		type: 'convex',
+		polyhedral: true,
 		points: [
 			[0.0, 0.0, 0.0],
 			[0.0, 1.0, 0.0],
@@ -181,6 +182,149 @@ function randomShapeScene(numObjects) {
 	return worldDescription;
 }
 
+function tableScene(numObjects) {
+	var worldDescription = {};
+	worldDescription.shapes = [];
+	worldDescription.shapes.push({
+		name: 'top',
+		type: 'cube',
+		wx: 4,
+		wy: 0.5,
+		wz: 2
+	});
+	worldDescription.shapes.push({
+		name: 'leg',
+		type: 'cube',
+		wx: 0.4,
+		wy: 2,
+		wz: 0.4
+	});
+	var table = {
+		name: 'table',
+		type: 'compound',
+		children: [{shape: 'top', position: {x: 0, y: 1.25, z: 0}}]
+	};
+	var legX = [-1.7, 1.7, -1.7, 1.7];
+	var legZ = [-0.7, -0.7, 0.7, 0.7];
+	for (var i = 0; i < 4; i++) {
+		table.children.push({shape: 'leg', position: {x: legX[i], y: 0, z: legZ[i]}});
+	}
+	worldDescription.shapes.push(table);
+
+	worldDescription.bodies = [];
+	for (var i = 0; i < numObjects; i++) {
+		var body = {};
+		body.shape = 'table';
+		body.position = {};
+		body.position.x = Math.random() * 10 - 25;
+		body.position.y = Math.random() * 50 + 2;
+		body.position.z = Math.random() * 40 - 20;
+		body.rotation = {};
+		body.rotation.x = ( Math.random() * 360 ) * Math.PI / 180;
+		body.rotation.y = ( Math.random() * 360 ) * Math.PI / 180;
+		body.rotation.z = ( Math.random() * 360 ) * Math.PI / 180;
+		body.mass = 1.0;
+		body.friction = 0.6;
+		worldDescription.bodies.push(body);
+	}
+	return worldDescription;
+}
+function terrainScene(numObjects) {
+	var worldDescription = {};
+	var size = 64;
+	var heights = new Float32Array(size * size);
+	for (var j = 0; j < size; j++) {
+		for (var i = 0; i < size; i++) {
+			heights[j * size + i] = 3.0 * Math.sin(i * 0.2) * Math.cos(j * 0.15);
+		}
+	}
+	worldDescription.shapes = [];
+	worldDescription.shapes.push({
+		name: 'terrain',
+		type: 'heightfield',
+		width: size,
+		length: size,
+		spacing: 1.0,
+		heights: heights
+	});
+	worldDescription.shapes.push({
+		name: 'box',
+		type: 'cube',
+		wx: 1,
+		wy: 1,
+		wz: 1
+	});
+	worldDescription.bodies = [];
+	worldDescription.bodies.push({
+		shape: 'terrain',
+		position: {x: 0, y: 4, z: 0},
+		rotation: {x: 0, y: 0, z: 0},
+		mass: 0.0,
+		friction: 0.8
+	});
+	for (var i = 0; i < numObjects; i++) {
+		var body = {};
+		body.shape = 'box';
+		body.position = {};
+		body.position.x = Math.random() * 40 - 20;
+		body.position.y = Math.random() * 30 + 10;
+		body.position.z = Math.random() * 40 - 20;
+		body.rotation = {};
+		body.rotation.x = ( Math.random() * 360 ) * Math.PI / 180;
+		body.rotation.y = ( Math.random() * 360 ) * Math.PI / 180;
+		body.rotation.z = ( Math.random() * 360 ) * Math.PI / 180;
+		body.mass = 1.0;
+		body.friction = 0.8;
+		worldDescription.bodies.push(body);
+	}
+	return worldDescription;
+}
+
+// Small cubes dropped from high enough to pass through a thin plate in one
+// step. With ccd set they are swept each step instead.
+function fallingCubesScene(numObjects, ccd) {
+	var worldDescription = {};
+	worldDescription.shapes = [];
+	worldDescription.shapes.push({
+		name: 'plate',
+		type: 'cube',
+		wx: 40,
+		wy: 0.1,
+		wz: 40
+	});
+	worldDescription.shapes.push({
+		name: 'small',
+		type: 'cube',
+		wx: 0.2,
+		wy: 0.2,
+		wz: 0.2
+	});
+	worldDescription.bodies = [];
+	worldDescription.bodies.push({
+		shape: 'plate',
+		position: {x: 0, y: 10, z: 0},
+		rotation: {x: 0, y: 0, z: 0},
+		mass: 0.0,
+		friction: 0.8
+	});
+	for ( var i = 0; i < numObjects; i ++ ) {
+		var body = {};
+		body.shape = 'small';
+		body.position = {};
+		body.position.x = Math.random() * 30 - 15;
+		body.position.y = Math.random() * 100 + 400;
+		body.position.z = Math.random() * 30 - 15;
+		body.rotation = {x: 0, y: 0, z: 0};
+		body.mass = 1.0;
+		body.friction = 0.8;
+		if (ccd) {
+			body.ccdMotionThreshold = 0.05;
+			body.ccdSweptSphereRadius = 0.08;
+		}
+		worldDescription.bodies.push(body);
+	}
+	return worldDescription;
+}
 
 function loadJenga5() {
 	loadWorld(jengaScene(5));
@@ -202,10 +346,81 @@ function load400RandomCubes() {
 	loadWorld(randomCubeScene(400));
 }
 
+// Debris is in its own collision filter group and left out of its own mask,
+// so the broadphase drops debris against debris pairs.
+function load400DebrisCubes() {
+	var worldDescription = randomCubeScene(400);
+	for (var i = 0; i < worldDescription.bodies.length; i++) {
+		worldDescription.bodies[i].group = 64;
+		worldDescription.bodies[i].mask = -1 ^ 64;
+	}
+	loadWorld(worldDescription);
+}
+
 function load400RandomCylinders() {
 	loadWorld(randomCylinderScene(400));
 }
 
+function loadFallingCubes() {
+	loadWorld(fallingCubesScene(200, false));
+}
+
+function loadFallingCubesCCD() {
+	loadWorld(fallingCubesScene(200, true));
+}
+
+function load100Tables() {
+	loadWorld(tableScene(100));
+}
+
+function loadTerrain() {
+	loadWorld(terrainScene(200));
+}
+
+// Loads an empty scene, then streams cubes into it in batches.
+function streamCubes(numObjects) {
+	var worldDescription = randomCubeScene(0);
+	loadWorld(worldDescription);
+	var batchSize = 1000;
+	for (var first = 0; first < numObjects; first += batchSize) {
+		var bodies = [];
+		for (var i = first; i < Math.min(first + batchSize, numObjects); i++) {
+			var body = {};
+			body.shape = 'box';
+			body.position = {};
+			body.position.x = (i % 25) * 1.5 - 18;
+			body.position.y = Math.floor(i / 500) * 1.5 + 1;
+			body.position.z = (Math.floor(i / 25) % 20) * 1.5 - 15;
+			body.rotation = {x: 0, y: 0, z: 0};
+			body.mass = 1.0;
+			body.friction = 0.8;
+			loadBody(body);
+			bodies.push(body);
+		}
+		NaClAMBulletAddBodies('box', bodies, 500);
+	}
+}
+
+function stream10000Cubes() {
+	streamCubes(10000);
+}
+
+function settleScene() {
+	NaClAMBulletSettle(600);
+}
+
+function removeRandomBodies(count) {
+	var indices = [];
+	for (var i = 0; i < count && i < objects.length; i++) {
+		indices.push(Math.floor(Math.random() * objects.length));
+	}
+	NaClAMBulletRemoveBodies(indices);
+}
+
+function remove100Bodies() {
+	removeRandomBodies(100);
+}
+
 function loadTextScene(evt) {
 	var txt = evt.target.result;
 	if (txt == undefined) {
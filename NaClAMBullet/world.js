@@ -58,6 +58,10 @@ function verifyBodyDescription(body, shapes) {
 		console.log('Body needs a transform array.');
 		return false;
 	}
+	if (body['ccdMotionThreshold'] != undefined && body['ccdSweptSphereRadius'] == undefined) {
+		console.log('Body with a ccdMotionThreshold needs a ccdSweptSphereRadius.');
+		return false;
+	}
 	return verifyShapeExists(shapeName, shapes);
 }
 
@@ -72,7 +76,10 @@ function verifyShapeDescription(shape) {
 	if (type != "cube" &&
 		type != "sphere" &&
 		type != "cylinder" &&
-		type != "convex") {
+		type != "convex" &&
+		type != "compound" &&
+		type != "trimesh" &&
+		type != "heightfield") {
 		console.log('Shape type - ' + type + ' not supported.');
 		return false;
 	}
@@ -93,6 +100,18 @@ function verifyShapeDescription(shape) {
 		return verifyConvexDescription(shape);
 	}
 
+	if (type == "compound") {
+		return verifyCompoundDescription(shape);
+	}
+
+	if (type == "trimesh") {
+		return verifyTrimeshDescription(shape);
+	}
+
+	if (type == "heightfield") {
+		return verifyHeightfieldDescription(shape);
+	}
+
 	return false;
 }
 
@@ -134,4 +153,44 @@ function verifyConvexDescription(shape) {
 		return false;
 	}
 	return true;
+}
+
+function verifyCompoundDescription(shape) {
+	var children = shape['children'];
+	if (children == undefined || children[0] == undefined) {
+		console.log('Compound shape needs children.');
+		return false;
+	}
+	for (var i = 0; i < children.length; i++) {
+		if (children[i]['shape'] == undefined) {
+			console.log('Compound child needs a shapename.');
+			return false;
+		}
+	}
+	return true;
+}
+
+function verifyTrimeshDescription(shape) {
+	if (shape['vertices'] == undefined) {
+		console.log('Triangle mesh needs vertices.');
+		return false;
+	}
+	if (shape['indices'] == undefined) {
+		console.log('Triangle mesh needs indices.');
+		return false;
+	}
+	return true;
+}
+
+function verifyHeightfieldDescription(shape) {
+	if (shape['width'] == undefined || shape['length'] == undefined) {
+		console.log('Heightfield needs a width and length.');
+		return false;
+	}
+	if (shape['heights'] == undefined ||
+		shape['heights'].length < shape['width'] * shape['length']) {
+		console.log('Heightfield needs width * length heights.');
+		return false;
+	}
+	return true;
 }
\ No newline at end of file
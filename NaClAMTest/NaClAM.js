@@ -14,6 +14,7 @@ function NaClAM(embedId) {
 	this.message = new NaClAMMessage();
 	this.state = 0;
 	this.framesLeft = 0;
+	this.droppedLogLines = 0;
 	this.listeners_ = Object.create(null);
 	this.handleMesssage_ = this.handleMesssage_.bind(this);
 }
@@ -26,8 +27,36 @@ NaClAM.prototype.disable = function() {
 	window.removeEventListener('message', this.handleMesssage_, true);
 }
 
-NaClAM.prototype.log_ = function(msg) {
-	console.log(msg);
+NaClAM.prototype.log_ = function(msg, level) {
+	if (level == 3) {
+		console.error(msg);
+	} else if (level == 2) {
+		console.warn(msg);
+	} else {
+		console.log(msg);
+	}
+}
+
+/**
+ * Logs a heartbeat's worth of lines sent by NaClAMLogf in one message.
+ * Levels are 0 debug, 1 info, 2 warning and 3 error.
+ */
+NaClAM.prototype.logBatch_ = function(header) {
+	var levels = header['levels'];
+	var lines = header['lines'];
+	var dropped = header['dropped'];
+	var i;
+	for (i = 0; i < lines.length; i++) {
+		this.log_(lines[i], levels[i]);
+	}
+	var numDropped = 0;
+	for (i = 0; i < dropped.length; i++) {
+		numDropped += dropped[i];
+	}
+	if (numDropped > 0) {
+		this.droppedLogLines += numDropped;
+		this.log_('NaClAM: Dropped ' + numDropped + ' log lines (debug/info/warning/error ' + dropped.join('/') + ').', 2);
+	}
 }
 
 NaClAM.prototype.handleMesssage_ = function(event) {
@@ -40,6 +69,10 @@ NaClAM.prototype.handleMesssage_ = function(event) {
 			this.log_(header['print'])
 			return;
 		}
+		if (header['cmd'] == 'NaClAMLog') {
+			this.logBatch_(header);
+			return;
+		}
 		if (typeof(header['request']) != "number") {
 			console.log('Header message requestId is not a number.');
 			return;